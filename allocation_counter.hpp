@@ -0,0 +1,49 @@
+#ifndef _TELL_ALLOCATION_COUNTER_HPP
+#define _TELL_ALLOCATION_COUNTER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <boost/config.hpp>
+
+/// \file
+/// \brief Replacements for the global operator new and operator delete that count the allocations
+///
+/// This is for the benchmark and the tests, each of which is a single translation unit;
+/// don't include it in more than one translation unit of a program.
+
+namespace {
+
+	/// \brief The number of calls to the global operator new
+	::std::atomic<size_t> num_allocations{ 0 };
+
+} // namespace
+
+// These are kept out of line so GCC doesn't see (and warn about) free() of memory from operator new
+
+/// \brief Counting replacement for the global operator new
+BOOST_NOINLINE void * operator new(size_t prm_size ///< The number of bytes to allocate
+                                   ) {
+	++num_allocations;
+	if ( void * const ptr = ::std::malloc( prm_size ) ) {
+		return ptr;
+	}
+	throw ::std::bad_alloc{};
+}
+
+/// \brief Replacement for the global operator delete to match the counting operator new
+BOOST_NOINLINE void operator delete(void * prm_ptr ///< The memory to free
+                                    ) noexcept {
+	::std::free( prm_ptr );
+}
+
+/// \brief Replacement for the global sized operator delete to match the counting operator new
+BOOST_NOINLINE void operator delete(void   * prm_ptr, ///< The memory to free
+                                    size_t   /*prm_size*/
+                                    ) noexcept {
+	::std::free( prm_ptr );
+}
+
+#endif // _TELL_ALLOCATION_COUNTER_HPP
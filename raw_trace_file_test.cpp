@@ -0,0 +1,229 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/format.hpp>
+
+#include "tell/capture_policy.hpp"
+#include "tell/detail/captured_frames.hpp"
+#include "tell/detail/loaded_module_map.hpp"
+#include "tell/raw_trace_file.hpp"
+#include "tell/tell_throw.hpp"
+
+/// \file
+/// \brief A round-trip test of the raw trace format: records written by write_exception_info_raw_trace() are read back by raw_trace_reader
+///
+/// This writes records for exceptions thrown via TELL_THROW() with a captured stacktrace, with the capture skipped and
+/// with a truncated capture, reads them back and checks every field. It also checks that an incomplete record at the end
+/// is reported (rather than read). It exits with a non-zero status if any check fails.
+
+using ::std::cout;
+
+namespace {
+
+	/// \brief The number of checks that have failed
+	size_t num_failures = 0;
+
+	/// \brief Record and report the specified check
+	void check(const bool          &prm_passed,     ///< Whether the check passed
+	           const ::std::string &prm_description ///< A description of the check
+	           ) {
+		if ( ! prm_passed ) {
+			++num_failures;
+		}
+		cout << ( prm_passed ? "PASS: " : "FAIL: " ) << prm_description << "\n";
+	}
+
+	/// \brief An exception type derived from std::exception
+	struct test_exception : public virtual ::boost::exception,
+	                        public virtual ::std::exception {
+		/// \brief Return a fixed message
+		const char * what() const noexcept final {
+			return "test exception";
+		}
+	};
+
+	/// \brief An exception type that isn't a std::exception (so has no what())
+	struct test_exception_without_what : public virtual ::boost::exception {
+	};
+
+	/// \brief A counter incremented after each nested call in call_at_depth(), which stops the calls being tail calls
+	::std::atomic<size_t> num_nested_returns{ 0 };
+
+	/// \brief Call the specified function from within the specified number of nested (non-inlined) frames
+	template <typename Fn>
+	BOOST_NOINLINE void call_at_depth(const size_t  &prm_depth, ///< The number of nested frames from which to call the function
+	                                  Fn           &&prm_fn     ///< The function to call
+	                                  ) {
+		if ( prm_depth <= 1 ) {
+			prm_fn();
+		}
+		else {
+			call_at_depth( prm_depth - 1, prm_fn );
+		}
+		num_nested_returns.fetch_add( 1, ::std::memory_order_relaxed );
+	}
+
+	/// \brief Whether the tests' TELL_THROW()s should throw (always true; this just stops GCC judging call_at_depth() infinitely recursive)
+	::std::atomic<bool> should_throw{ true };
+
+	/// \brief Throw an Ex via TELL_THROW() from within the specified number of nested frames and return it
+	template <typename Ex>
+	Ex make_exception_at_depth(const size_t &prm_depth ///< The number of nested frames from which to throw
+	                           ) {
+		try {
+			call_at_depth( prm_depth, [] {
+				if ( should_throw.load( ::std::memory_order_relaxed ) ) {
+					TELL_THROW( Ex{} );
+				}
+			} );
+		}
+		catch (const Ex &exception) {
+			return exception;
+		}
+		return {};
+	}
+
+	/// \brief Get the current time in nanoseconds since the Unix epoch
+	uint64_t now_ns() {
+		return static_cast<uint64_t>( ::std::chrono::duration_cast<::std::chrono::nanoseconds>(
+			::std::chrono::system_clock::now().time_since_epoch()
+		).count() );
+	}
+
+	/// \brief Check that the specified record matches the specified exception, which was written between the specified times
+	template <typename Ex>
+	void check_record(const ::std::string                    &prm_name,          ///< The name of the record (for the report)
+	                  const ::tell::except::raw_trace_record &prm_record,        ///< The record that was read
+	                  const Ex                               &prm_exception,     ///< The exception from which the record was written
+	                  const uint64_t                         &prm_written_after, ///< A time before the record was written
+	                  const uint64_t                         &prm_written_before ///< A time after the record was written
+	                  ) {
+		const auto * const function_value_ptr = ::boost::get_error_info< ::boost::throw_function >( prm_exception );
+		const auto * const file_value_ptr     = ::boost::get_error_info< ::boost::throw_file     >( prm_exception );
+		const auto * const line_value_ptr     = ::boost::get_error_info< ::boost::throw_line     >( prm_exception );
+		const char * const what_ptr           = ::tell::except::detail::get_what_ptr_of_std_exception( prm_exception );
+
+		check( prm_record.timestamp_ns >= prm_written_after && prm_record.timestamp_ns <= prm_written_before, prm_name + ": timestamp is the time of writing" );
+		check( prm_record.pid == static_cast<uint64_t>( ::getpid() ),                                         prm_name + ": pid is the writer's"           );
+		check( prm_record.type_name == typeid( prm_exception ).name(),                                        prm_name + ": type name"                     );
+		check( function_value_ptr != nullptr && prm_record.function == ::std::string{ *function_value_ptr },  prm_name + ": throw function"                 );
+		check( file_value_ptr     != nullptr && prm_record.file     == ::std::string{ *file_value_ptr     },  prm_name + ": throw file"                     );
+		check( line_value_ptr     != nullptr && prm_record.line     == *line_value_ptr,                       prm_name + ": throw line"                     );
+		check( ( what_ptr == nullptr ) ? ! prm_record.what : ( prm_record.what == ::std::string{ what_ptr } ), prm_name + ": what()"                        );
+
+		// Each frame should be stored as its offset in the module that contains it
+		::std::vector<uintptr_t> addresses;
+		::tell::except::detail::visit_captured_frames( prm_exception, [&] (const auto &x) {
+			for (const auto &frame : x) {
+				addresses.push_back( reinterpret_cast<uintptr_t>( ::tell::except::detail::frame_address( frame ) ) );
+			}
+		} );
+		bool frames_match = ( prm_record.frames.size() == addresses.size() );
+		for (size_t frame_ctr = 0; frames_match && frame_ctr < addresses.size(); ++frame_ctr) {
+			const auto &the_frame  = prm_record.frames[ frame_ctr ];
+			const auto  the_module = ::tell::except::detail::loaded_module_map::instance().find_shared( addresses[ frame_ctr ] );
+			if ( ! the_module ) {
+				frames_match = ! the_frame.module_index && the_frame.offset == addresses[ frame_ctr ];
+			}
+			else {
+				frames_match = the_frame.module_index
+					&& *the_frame.module_index < prm_record.modules.size()
+					&& prm_record.modules[ *the_frame.module_index ].path     == the_module->path
+					&& prm_record.modules[ *the_frame.module_index ].build_id == the_module->build_id
+					&& the_frame.offset == addresses[ frame_ctr ] - the_module->load_bias;
+			}
+		}
+		check( frames_match, prm_name + ": " + ::std::to_string( addresses.size() ) + " frames, as module offsets" );
+	}
+
+} // namespace
+
+/// \brief Write raw trace records, read them back and check them, and exit with a non-zero status if any check fails
+int main() {
+	using ::tell::except::capture_depth;
+	using ::tell::except::capture_policy;
+	using ::tell::except::raw_trace_reader;
+	using ::tell::except::raw_trace_record;
+
+	const auto captured_exception  = make_exception_at_depth<test_exception>( 8 );
+	::tell::except::set_default_capture_policy( capture_policy::first_n( 0 ) );
+	const auto skipped_exception   = make_exception_at_depth<test_exception_without_what>( 8 );
+	::tell::except::set_default_capture_policy( capture_policy::always() );
+	::tell::except::set_default_capture_depth( capture_depth::at_most( 4 ) );
+	const auto truncated_exception = make_exception_at_depth<test_exception>( 16 );
+	::tell::except::set_default_capture_depth( capture_depth::unlimited() );
+
+	::std::string  records;
+	const uint64_t written_after     = now_ns();
+	::tell::except::write_exception_info_raw_trace( ::tell::except::string_sink{ records }, captured_exception  );
+	::tell::except::write_exception_info_raw_trace( ::tell::except::string_sink{ records }, skipped_exception   );
+	const size_t   last_record_start = records.size();
+	::tell::except::write_exception_info_raw_trace( ::tell::except::string_sink{ records }, truncated_exception );
+	const uint64_t written_before    = now_ns();
+
+	// Read back the complete records
+	{
+		raw_trace_reader reader{ reinterpret_cast<const unsigned char *>( records.data() ), records.size() };
+		raw_trace_record captured_record;
+		raw_trace_record skipped_record;
+		raw_trace_record truncated_record;
+		raw_trace_record extra_record;
+		check( reader.next( captured_record  ), "captured: read"  );
+		check( reader.next( skipped_record   ), "skipped: read"   );
+		check( reader.next( truncated_record ), "truncated: read" );
+		check( ! reader.next( extra_record ) && reader.ok() && reader.remaining() == 0, "all records read, with nothing left over" );
+
+		check_record( "captured", captured_record, captured_exception, written_after, written_before );
+		check( ! captured_record.capture_skipped_by,                        "captured: not skipped"        );
+		check( ! captured_record.truncated,                                 "captured: not truncated"      );
+		check( ! captured_record.frames.empty(),                            "captured: has frames"         );
+		check( static_cast<bool>( captured_record.frames.front().module_index ),     "captured: innermost frame's module is known" );
+
+		check_record( "skipped", skipped_record, skipped_exception, written_after, written_before );
+		check( skipped_record.capture_skipped_by && skipped_record.capture_skipped_by->pack() == capture_policy::first_n( 0 ).pack(), "skipped: skipping policy" );
+		check( ! skipped_record.truncated,                                  "skipped: not truncated"       );
+		check( skipped_record.modules.empty() && skipped_record.frames.empty(), "skipped: no modules or frames" );
+
+		check_record( "truncated", truncated_record, truncated_exception, written_after, written_before );
+		check( ! truncated_record.capture_skipped_by,                       "truncated: not skipped"       );
+		check( truncated_record.truncated,                                  "truncated: truncated"         );
+		check( truncated_record.frames.size() == 4,                         "truncated: capture_depth's number of frames" );
+	}
+
+	// A record cut short (as by a writer that's still writing, or that crashed) is reported, not read
+	{
+		const size_t     num_tail_bytes = 7;
+		const size_t     cut_size       = records.size() - num_tail_bytes;
+		raw_trace_reader reader{ reinterpret_cast<const unsigned char *>( records.data() ), cut_size };
+		raw_trace_record the_record;
+		const size_t     tail_size      = cut_size - last_record_start;
+		check( reader.next( the_record ) && reader.next( the_record ),        "cut short: complete records read" );
+		check( ! reader.next( the_record ),                                   "cut short: incomplete record not read" );
+		check( ! reader.ok(),                                                 "cut short: not ok()" );
+		check( reader.remaining() == tail_size,                               "cut short: remaining() is the incomplete record's " + ::std::to_string( tail_size ) + " bytes" );
+		check( ! reader.next( the_record ) && reader.remaining() == tail_size, "cut short: reading stops at the incomplete record" );
+	}
+
+	// A record that doesn't start with the magic is reported, not read
+	{
+		::std::string    corrupted = records;
+		corrupted[ 0 ] = 'X';
+		raw_trace_reader reader{ reinterpret_cast<const unsigned char *>( corrupted.data() ), corrupted.size() };
+		raw_trace_record the_record;
+		check( ! reader.next( the_record ) && ! reader.ok() && reader.remaining() == corrupted.size(), "bad magic: nothing read and everything remaining" );
+	}
+
+	cout << ::boost::format( "%d check(s) failed\n" ) % num_failures;
+	return ( num_failures == 0 ) ? 0 : 1;
+}
+
+// g++ -I source/src_stacktrace -W -Wall -Werror -Wextra -pedantic -Wcast-qual -Wconversion -Wnon-virtual-dtor -Wshadow -Wsign-compare -Wsign-conversion -rdynamic -O2 -g -std=c++14 raw_trace_file_test.cpp -DBOOST_STACKTRACE_DYN_LINK -isystem /opt/boost_1_67_0_gcc_c++14_build/include -Wl,-rpath,/opt/boost_1_67_0_gcc_c++14_build/lib /opt/boost_1_67_0_gcc_c++14_build/lib/libboost_stacktrace_basic-mt-d.so -ldl -o raw_trace_file_test.gcc_basic_bin && ./raw_trace_file_test.gcc_basic_bin
+//
+// Add -DTELL_USE_RAW_FRAMES to test the raw frames' records
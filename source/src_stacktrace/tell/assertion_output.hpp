@@ -0,0 +1,142 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_ASSERTION_OUTPUT_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_ASSERTION_OUTPUT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+
+#include "tell/detail/char_buffer_writer.hpp"
+#include "tell/detail/config.hpp"
+#include "tell/detail/raw_frames.hpp"
+#include "tell/detail/types.hpp"
+#include "tell/detail/write_fully.hpp"
+#include "tell/output_sinks.hpp"
+#include "tell/stacktrace_to_cleaned_string.hpp"
+
+namespace tell { namespace except {
+
+	namespace detail {
+
+		/// \brief The run-time settings for the output of assertion failures
+		struct assertion_output_settings final {
+			/// \brief The file descriptor to which assertion failures are written
+			::std::atomic<int>  fd{ STDERR_FILENO };
+
+			/// \brief Whether to follow the raw frames with a best-effort symbolized stacktrace
+			::std::atomic<bool> symbolize{ true };
+		};
+
+		/// \brief Get the process-wide assertion_output_settings
+		inline assertion_output_settings & get_assertion_output_settings() {
+			static assertion_output_settings the_settings;
+			return the_settings;
+		}
+
+		/// \brief Format a description of an assertion failure with the raw frame addresses into the specified writer
+		///
+		/// This doesn't allocate, lock or symbolize
+		inline void format_assertion_failure(char_buffer_writer &prm_writer,   ///< The writer into which the description should be formatted
+		                                     const char         *prm_expr,     ///< The assertion expression that has failed
+		                                     const char         *prm_msg,      ///< The message associated with the assertion or nullptr if none
+		                                     const char         *prm_function, ///< The name of the function containing the assertion
+		                                     const char         *prm_file,     ///< The name of the file containing the assertion
+		                                     const int64_t      &prm_line,     ///< The line number on which the assertion appears
+		                                     const raw_frames_t &prm_frames    ///< The frames of the stack at the assertion
+		                                     ) noexcept {
+			prm_writer.write( "[ASSERTION ERROR] Failed assertion '" ).write( prm_expr );
+			if ( prm_msg != nullptr ) {
+				prm_writer.write( "' with message '" ).write( prm_msg );
+			}
+			prm_writer.write( "' at " ).write( prm_file ).write( ":" ).write_decimal( prm_line )
+				.write( " in '" ).write( prm_function ).write( "'\nRaw stacktrace:\n" );
+			int64_t frame_ctr = 0;
+			for (const auto &address : prm_frames) {
+				prm_writer.write_decimal( frame_ctr++, 4 ).write( "  " ).write_hex( reinterpret_cast<uintptr_t>( address ) ).write( "\n" );
+			}
+			if ( prm_frames.is_truncated() ) {
+				write_truncation_marker( prm_writer, prm_frames.size() );
+			}
+		}
+
+		/// \brief Emit a description of an assertion failure to the configured file descriptor
+		///
+		/// The first stage formats the description and the raw frame addresses into a preallocated
+		/// static buffer and emits it with a single write(2), so the essential information gets out
+		/// even if the heap is corrupt or a lock is held. If configured (which is the default), a second,
+		/// best-effort stage then symbolizes the frames (which may allocate) and writes those.
+		///
+		/// If several threads fail assertions concurrently, only one uses the static buffer and the
+		/// others format onto their own stacks.
+		inline void emit_assertion_failure(const char         *prm_expr,     ///< The assertion expression that has failed
+		                                   const char         *prm_msg,      ///< The message associated with the assertion or nullptr if none
+		                                   const char         *prm_function, ///< The name of the function containing the assertion
+		                                   const char         *prm_file,     ///< The name of the file containing the assertion
+		                                   const int64_t      &prm_line,     ///< The line number on which the assertion appears
+		                                   const raw_frames_t &prm_frames    ///< The frames of the stack at the assertion
+		                                   ) noexcept {
+			static char               static_buffer[ TELL_ASSERTION_BUFFER_SIZE ];
+			static ::std::atomic_flag static_buffer_in_use = ATOMIC_FLAG_INIT;
+
+			static constexpr char     truncated_marker[] = "\n[TRUNCATED]\n";
+			constexpr size_t          marker_length      = sizeof( truncated_marker ) - 1;
+
+			const auto &settings = get_assertion_output_settings();
+			const int   fd       = settings.fd.load();
+
+			{
+				const bool   use_static_buffer = ! static_buffer_in_use.test_and_set();
+				char         stack_buffer[ 2048 ];
+				char * const buffer            = use_static_buffer ? static_buffer           : stack_buffer;
+				const size_t buffer_size       = use_static_buffer ? sizeof( static_buffer ) : sizeof( stack_buffer );
+
+				// Leave room to mark the output as truncated if it doesn't all fit
+				char_buffer_writer writer{ buffer, buffer_size - marker_length };
+				format_assertion_failure( writer, prm_expr, prm_msg, prm_function, prm_file, prm_line, prm_frames );
+				size_t length = writer.size();
+				if ( writer.was_truncated() ) {
+					::std::memcpy( buffer + length, truncated_marker, marker_length );
+					length += marker_length;
+				}
+				write_fully( fd, buffer, length );
+				if ( use_static_buffer ) {
+					static_buffer_in_use.clear();
+				}
+			}
+
+			if ( settings.symbolize.load() ) {
+				try {
+					::std::string symbolized = "Stacktrace:\n" + to_string_unstripped( prm_frames );
+					if ( prm_frames.is_truncated() ) {
+						string_sink sink{ symbolized };
+						write_truncation_marker( sink, prm_frames.size() );
+					}
+					write_fully( fd, symbolized.data(), symbolized.size() );
+				}
+				catch (...) {
+					// The symbolized stacktrace is best-effort so swallow any failure
+				}
+			}
+		}
+
+	} // namespace detail
+
+	/// \brief Set the file descriptor to which assertion failures are written when TELL_ASSERT_SINGLE_WRITE is defined (default: stderr)
+	inline void set_assertion_output_fd(const int &prm_fd ///< The file descriptor
+	                                    ) {
+		detail::get_assertion_output_settings().fd.store( prm_fd );
+	}
+
+	/// \brief Set whether assertion failures emitted when TELL_ASSERT_SINGLE_WRITE is defined are followed by a
+	///        best-effort symbolized stacktrace (default: true)
+	inline void set_assertion_output_symbolization(const bool &prm_symbolize ///< Whether to add the symbolized stacktrace
+	                                               ) {
+		detail::get_assertion_output_settings().symbolize.store( prm_symbolize );
+	}
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_ASSERTION_OUTPUT_HPP
@@ -0,0 +1,417 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_ASYNC_RENDERER_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_ASYNC_RENDERER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <boost/exception/get_error_info.hpp>
+#include <boost/optional.hpp>
+#include <boost/stacktrace.hpp>
+
+#include "tell/capture_policy.hpp"
+#include "tell/detail/bounded_stacktrace.hpp"
+#include "tell/detail/captured_frames.hpp"
+#include "tell/detail/raw_frames.hpp"
+#include "tell/detail/types.hpp"
+#include "tell/instrumentation.hpp"
+#include "tell/output_sinks.hpp"
+#include "tell/retrieve_exception_info.hpp"
+
+/// \file
+/// \brief Rendering of exception info on background threads, so the catching thread never symbolizes
+///
+/// The catching thread only copies out the raw frames and the small throw-site metadata (which
+/// needs no symbolization) and gets back a std::future for the rendered text straight away.
+
+namespace tell { namespace except {
+
+	namespace detail {
+
+		/// \brief The information needed to render a description of an exception, extracted from it without any symbolization
+		///
+		/// The function and file are kept as pointers because Boost Exception's throw_function and throw_file
+		/// store pointers to string literals (as do BOOST_THROW_EXCEPTION_CURRENT_FUNCTION and __FILE__)
+		struct pending_exception_info final {
+			/// \brief The dynamic type of the exception
+			const ::std::type_info *                           type_ptr           = nullptr;
+
+			/// \brief The name of the function containing the code that threw, or nullptr if not known
+			const char *                                       function           = nullptr;
+
+			/// \brief The name of the source file containing the code that threw, or nullptr if not known
+			const char *                                       file               = nullptr;
+
+			/// \brief The number of the source line containing the code that threw, or none if not known
+			::boost::optional<throw_line_value_t>              line;
+
+			/// \brief The what() of the exception, or none if it isn't a std::exception
+			::boost::optional<::std::string>                   what;
+
+			/// \brief The frames captured as a bounded_stacktrace, if that's how they were captured
+			::boost::optional<bounded_stacktrace>              stacktrace;
+
+			/// \brief The frames captured as a raw_frames_t, if that's how they were captured
+			::boost::optional<raw_frames_t>                    raw_frames;
+
+			/// \brief The number of frames kept, if the capture was truncated
+			::boost::optional<size_t>                          truncation;
+
+			/// \brief The capture_policy that skipped the capture, if it was skipped
+			::boost::optional<capture_policy>                  capture_skipped_by;
+
+			/// \brief The name of the function containing the code that's retrieving the information, or nullptr for no retrieval context
+			const char *                                       context_function   = nullptr;
+
+			/// \brief The name of the source file containing the code that's retrieving the information
+			const char *                                       context_file       = nullptr;
+
+			/// \brief The number of the source line containing the code that's retrieving the information
+			throw_line_value_t                                 context_line       = 0;
+
+			/// \brief Store a copy of the specified frames, captured as a bounded_stacktrace
+			void set_frames(const bounded_stacktrace &prm_stacktrace ///< The frames
+			                ) {
+				stacktrace = prm_stacktrace;
+			}
+
+			/// \brief Store a copy of the specified frames, captured as a raw_frames_t
+			void set_frames(const raw_frames_t &prm_raw_frames ///< The frames
+			                ) {
+				raw_frames = prm_raw_frames;
+			}
+		};
+
+		/// \brief Extract the information needed to render a description of the specified exception, without any symbolization
+		template <typename Ex>
+		pending_exception_info make_pending_exception_info(const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+		                                                   ) {
+			static_assert( ::std::is_base_of<::boost::exception, remove_cvref_t<Ex>>::value,
+				"tell can only render exception info asynchronously when passed with a static type derived from boost::exception (or boost::exception itself)" );
+
+			const auto * const function_value_ptr = ::boost::get_error_info< ::boost::throw_function >( prm_exception );
+			const auto * const file_value_ptr     = ::boost::get_error_info< ::boost::throw_file     >( prm_exception );
+			const auto * const line_value_ptr     = ::boost::get_error_info< ::boost::throw_line     >( prm_exception );
+			const char * const what_ptr           = get_what_ptr_of_std_exception( prm_exception );
+
+			pending_exception_info result;
+			result.type_ptr = &typeid( prm_exception );
+			result.function = ( function_value_ptr != nullptr ) ? *function_value_ptr : nullptr;
+			result.file     = ( file_value_ptr     != nullptr ) ? *file_value_ptr     : nullptr;
+			if ( line_value_ptr != nullptr ) {
+				result.line = *line_value_ptr;
+			}
+			if ( what_ptr != nullptr ) {
+				result.what = ::std::string{ what_ptr };
+			}
+			visit_throw_record(
+				prm_exception,
+				[&] (const auto &x) {
+					if ( const auto * const frames_ptr = x.get_frames() ) {
+						result.set_frames( *frames_ptr );
+					}
+					result.truncation         = x.get_truncation();
+					result.capture_skipped_by = x.get_capture_skipped_by();
+				}
+			);
+			return result;
+		}
+
+		/// \brief Write the description of the exception and where it was thrown (without any stacktrace)
+		///        from the specified pending_exception_info to the specified sink
+		template <typename Sink>
+		void write_pending_thrown_exception(Sink                         &prm_sink, ///< The sink to which the description should be written
+		                                    const pending_exception_info &prm_info  ///< The information extracted from the exception
+		                                    ) {
+			if ( prm_info.context_function != nullptr ) {
+				write_retrieval_context( prm_sink, prm_info.context_function, prm_info.context_file, prm_info.context_line );
+			}
+			write_thrown_exception_description(
+				prm_sink,
+				*prm_info.type_ptr,
+				prm_info.function,
+				prm_info.file,
+				prm_info.line.get_ptr(),
+				prm_info.what ? prm_info.what->c_str() : nullptr
+			);
+		}
+
+		/// \brief Write a full description of the exception from the specified pending_exception_info to the specified sink
+		///
+		/// This matches the output of write_exception_info()
+		template <typename Sink>
+		void write_pending_exception_info(Sink                         &prm_sink, ///< The sink to which the description should be written
+		                                  const pending_exception_info &prm_info  ///< The information extracted from the exception
+		                                  ) {
+			write_pending_thrown_exception( prm_sink, prm_info );
+			if ( prm_info.stacktrace ) {
+				write_captured_frames( prm_sink, *prm_info.stacktrace, prm_info.truncation );
+			}
+			else if ( prm_info.raw_frames ) {
+				write_captured_frames( prm_sink, *prm_info.raw_frames, prm_info.truncation );
+			}
+			else if ( prm_info.capture_skipped_by ) {
+				write_capture_skipped( prm_sink, *prm_info.capture_skipped_by );
+			}
+		}
+
+	} // namespace detail
+
+	/// \brief A snapshot of an async_renderer's counters
+	struct async_renderer_stats final {
+		/// \brief The number of exceptions submitted (including those dropped)
+		uint64_t submitted = 0;
+
+		/// \brief The number of exceptions rendered by the workers
+		uint64_t rendered  = 0;
+
+		/// \brief The number of exceptions not rendered by the workers because the queue was full
+		uint64_t dropped   = 0;
+
+		/// \brief The number of exceptions currently queued
+		size_t   queued    = 0;
+
+		/// \brief The maximum number of exceptions that can be queued
+		size_t   capacity  = 0;
+	};
+
+	/// \brief A bounded pool of worker threads that render exception info in the background
+	///
+	/// submit() copies the raw frames and the throw-site metadata out of the exception (without any
+	/// symbolization) onto a bounded queue and immediately returns a std::future for the rendered text
+	/// (which matches that of retrieve_exception_info()). The workers do the symbolization and formatting.
+	///
+	/// When the queue is full, the overflow_policy decides whether submit() drops the job (the default,
+	/// so the catching thread never waits) or waits for space. A dropped job's future is ready straight
+	/// away with the description of the exception but with the stacktrace marked as not rendered, and
+	/// it's counted in stats().
+	///
+	/// The dtor renders everything already queued before joining the workers, so no accepted job is lost on shutdown.
+	class async_renderer final {
+	public:
+		/// \brief What submit() should do when the queue is full
+		enum class overflow_policy : uint8_t {
+			DROP, ///< Don't queue the job; return a future that's ready with the stacktrace marked as not rendered
+			WAIT  ///< Wait for space in the queue
+		};
+
+	private:
+		/// \brief A single queued render
+		struct job final {
+			/// \brief The information extracted from the exception
+			detail::pending_exception_info  info;
+
+			/// \brief The promise of the rendered text
+			::std::promise<::std::string>   promise;
+		};
+
+		/// \brief The maximum number of jobs that can be queued
+		const size_t                    capacity;
+
+		/// \brief What submit() should do when the queue is full
+		const overflow_policy           on_overflow;
+
+		/// \brief Mutex to protect jobs, num_in_progress and stopping
+		mutable ::std::mutex            mutex;
+
+		/// \brief Condition variable to wake the workers when there's a job or the renderer is stopping
+		::std::condition_variable       work_available;
+
+		/// \brief Condition variable to wake submitters (waiting for space) and flushers (waiting for completion) when a job is taken or finished
+		::std::condition_variable       progress_made;
+
+		/// \brief The queued jobs
+		::std::deque<job>               jobs;
+
+		/// \brief The number of jobs currently being rendered
+		size_t                          num_in_progress = 0;
+
+		/// \brief Whether the renderer is stopping (so the workers should exit once the queue is empty)
+		bool                            stopping        = false;
+
+		/// \brief The number of exceptions submitted
+		::std::atomic<uint64_t>         num_submitted{ 0 };
+
+		/// \brief The number of exceptions rendered by the workers
+		::std::atomic<uint64_t>         num_rendered { 0 };
+
+		/// \brief The number of exceptions dropped because the queue was full
+		::std::atomic<uint64_t>         num_dropped  { 0 };
+
+		/// \brief The worker threads (declared last so they start after everything else is initialized)
+		::std::vector<::std::thread>    workers;
+
+		/// \brief Render the specified information into the specified job's promise
+		static void render(job &prm_job ///< The job to render
+		                   ) {
+			try {
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+				const auto render_start = detail::instrumentation_clock::now();
+#endif
+				::std::string result;
+				string_sink   sink{ result };
+				detail::write_pending_exception_info( sink, prm_job.info );
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+				detail::record_render( prm_job.info.file, prm_job.info.line.value_or( 0 ), detail::nanoseconds_since( render_start ) );
+#endif
+				prm_job.promise.set_value( ::std::move( result ) );
+			}
+			catch (...) {
+				prm_job.promise.set_exception( ::std::current_exception() );
+			}
+		}
+
+		/// \brief The body of each worker thread: render jobs until stopping and the queue is empty
+		void run_worker() {
+			while ( true ) {
+				::std::unique_lock<::std::mutex> lock{ mutex };
+				work_available.wait( lock, [&] { return stopping || ! jobs.empty(); } );
+				if ( jobs.empty() ) {
+					return;
+				}
+				job the_job = ::std::move( jobs.front() );
+				jobs.pop_front();
+				++num_in_progress;
+				lock.unlock();
+				progress_made.notify_all();
+
+				render( the_job );
+
+				lock.lock();
+				--num_in_progress;
+				++num_rendered;
+				lock.unlock();
+				progress_made.notify_all();
+			}
+		}
+
+		/// \brief Queue the specified information for rendering and return the future of the rendered text
+		::std::future<::std::string> enqueue(detail::pending_exception_info prm_info ///< The information extracted from the exception
+		                                     ) {
+			++num_submitted;
+			job the_job{ ::std::move( prm_info ), ::std::promise<::std::string>{} };
+			auto result = the_job.promise.get_future();
+			{
+				::std::unique_lock<::std::mutex> lock{ mutex };
+				if ( on_overflow == overflow_policy::WAIT ) {
+					progress_made.wait( lock, [&] { return jobs.size() < capacity; } );
+				}
+				if ( jobs.size() < capacity ) {
+					jobs.push_back( ::std::move( the_job ) );
+					lock.unlock();
+					work_available.notify_one();
+					return result;
+				}
+			}
+
+			// The queue is full, so describe the exception without its stacktrace (which needs no symbolization)
+			++num_dropped;
+			::std::string dropped_text;
+			string_sink   sink{ dropped_text };
+			detail::write_pending_thrown_exception( sink, the_job.info );
+			detail::write_cstring( sink, "\nStacktrace: not rendered (async_renderer queue full)\n" );
+			the_job.promise.set_value( ::std::move( dropped_text ) );
+			return result;
+		}
+
+	public:
+		/// \brief Ctor from the number of workers, the queue capacity and the overflow policy
+		explicit async_renderer(const size_t          &prm_num_workers    = 1,                    ///< The number of worker threads (where 0 is treated as 1)
+		                        const size_t          &prm_queue_capacity = 1024,                 ///< The maximum number of jobs that can be queued (where 0 is treated as 1)
+		                        const overflow_policy &prm_on_overflow    = overflow_policy::DROP ///< What submit() should do when the queue is full
+		                        ) : capacity   { ( prm_queue_capacity > 0 ) ? prm_queue_capacity : 1 },
+		                            on_overflow{ prm_on_overflow                                       } {
+			const size_t num_workers = ( prm_num_workers > 0 ) ? prm_num_workers : 1;
+			workers.reserve( num_workers );
+			for (size_t worker_ctr = 0; worker_ctr < num_workers; ++worker_ctr) {
+				workers.emplace_back( [this] { run_worker(); } );
+			}
+		}
+
+		async_renderer(const async_renderer &) = delete;
+		async_renderer(async_renderer &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
+		async_renderer & operator=(const async_renderer &) = delete;
+		async_renderer & operator=(async_renderer &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
+
+		/// \brief Dtor that renders everything already queued and then joins the workers
+		~async_renderer() {
+			{
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				stopping = true;
+			}
+			work_available.notify_all();
+			for (auto &worker : workers) {
+				worker.join();
+			}
+		}
+
+		/// \brief Submit the specified boost::exception for rendering, retrieving info added by TELL_THROW()
+		///
+		/// This doesn't symbolize anything; it just copies the frames and metadata out of the exception.
+		///
+		/// \returns A future for the text, which matches that of retrieve_exception_info()
+		template <typename Ex>
+		::std::future<::std::string> submit(const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+		                                    ) {
+			return enqueue( detail::make_pending_exception_info( prm_exception ) );
+		}
+
+		/// \brief Submit the specified boost::exception for rendering, retrieving info added by TELL_THROW()
+		///        including context information about where the information is being retrieved
+		///
+		/// Don't use this function directly, use the macro TELL_RETRIEVE_EXCEPTION_INFO_ASYNC()
+		///
+		/// \returns A future for the text, which matches that of TELL_RETRIEVE_EXCEPTION_INFO()
+		template <typename Ex>
+		::std::future<::std::string> submit(const Ex                             &prm_exception, ///< The boost::exception, hopefully thrown via TELL_THROW
+		                                    const detail::throw_function_value_t &prm_function,  ///< The name of the function containing the code that wants to retrieve this information
+		                                    const detail::throw_file_value_t     &prm_file,      ///< The name of the source file containing the code that wants to retrieve this information
+		                                    const detail::throw_line_value_t     &prm_line       ///< The number of the source line containing the code that wants to retrieve this information
+		                                    ) {
+			auto info = detail::make_pending_exception_info( prm_exception );
+			info.context_function = prm_function;
+			info.context_file     = prm_file;
+			info.context_line     = prm_line;
+			return enqueue( ::std::move( info ) );
+		}
+
+		/// \brief Wait until every job queued so far has been rendered
+		void flush() {
+			::std::unique_lock<::std::mutex> lock{ mutex };
+			progress_made.wait( lock, [&] { return jobs.empty() && num_in_progress == 0; } );
+		}
+
+		/// \brief Get a snapshot of the renderer's counters
+		async_renderer_stats stats() const {
+			async_renderer_stats result;
+			{
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				result.queued = jobs.size();
+			}
+			result.submitted = num_submitted.load();
+			result.rendered  = num_rendered.load();
+			result.dropped   = num_dropped.load();
+			result.capacity  = capacity;
+			return result;
+		}
+	};
+
+} // namespace except
+} // namespace tell
+
+/// \brief Submit the specified boost::exception to the specified async_renderer, retrieving info added by TELL_THROW()
+///        including context information about where the information is being retrieved
+///
+/// This returns a std::future for the text of TELL_RETRIEVE_EXCEPTION_INFO() without doing any symbolization in the calling thread
+#define TELL_RETRIEVE_EXCEPTION_INFO_ASYNC(r, x) ((r)).submit( ((x)), BOOST_THROW_EXCEPTION_CURRENT_FUNCTION, __FILE__, __LINE__ )
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_ASYNC_RENDERER_HPP
@@ -2,27 +2,80 @@
 #define _TELL_SOURCE_SRC_STACKTRACE_TELL_BOOST_ASSERT_HPP
 
 #include <iostream>
+#include <string>
 
+#include <boost/core/ignore_unused.hpp>
 #include <boost/stacktrace.hpp>
 
+#include "tell/assertion_output.hpp"
+#include "tell/capture_policy.hpp"
+#include "tell/detail/bounded_stacktrace.hpp"
+#include "tell/detail/raw_frames.hpp"
 #include "tell/detail/types.hpp"
+#include "tell/instrumentation.hpp"
+#include "tell/output_sinks.hpp"
 #include "tell/stacktrace_to_cleaned_string.hpp"
 
 using namespace ::std::literals::string_literals;
 
-namespace boost {
+namespace tell { namespace except { namespace detail {
 
-	/// \brief Handler for BOOST_ASSERT_MSG() failures
+#if defined( TELL_ASSERT_SINGLE_WRITE )
+
+	/// \brief Capture the current stack for an assertion failure, as raw frames without any heap allocation
 	///
-	/// This outputs a string describing the assertion failure with a stacktrace context
-	/// and then call abort() (which may result in a core dump, depending on system settings)
-	inline void assertion_failed_msg(char const * prm_expr,     ///< The assertion expression that has failed
-	                                 char const * prm_msg,      ///< The message associated with the assertion or nullptr if none
-	                                 char const * prm_function, ///< The name of the function containing the assertion
-	                                 char const * prm_file,     ///< The name of the file containing the assertion
-	                                 int64_t      prm_line      ///< The line number on which the assertion appears
-	                                 ) {
-		const auto prefixes_to_remove = { "boost::assertion_failed" };
+	/// This is forced inline so that the first frame is that of the caller, before the specified number of frames are skipped
+	BOOST_FORCEINLINE raw_frames_t capture_assertion_frames(const size_t &prm_skip,                                 ///< The number of (innermost) frames to skip
+	                                                        const size_t &prm_max_depth = static_cast<size_t>( -1 ) ///< The maximum number of frames to keep after skipping
+	                                                        ) noexcept {
+		return raw_frames_t::capture( prm_skip, prm_max_depth );
+	}
+
+#else
+
+	/// \brief Capture the current stack for an assertion failure, as a boost::stacktrace::stacktrace
+	///
+	/// This is forced inline so that the first frame is that of the caller, before the specified number of frames are skipped
+	BOOST_FORCEINLINE bounded_stacktrace capture_assertion_frames(const size_t &prm_skip,                                 ///< The number of (innermost) frames to skip
+	                                                              const size_t &prm_max_depth = static_cast<size_t>( -1 ) ///< The maximum number of frames to keep after skipping
+	                                                              ) {
+		return bounded_stacktrace::capture( prm_skip, prm_max_depth );
+	}
+
+#endif
+
+	/// \brief Output a string describing the assertion failure with the specified stacktrace
+	///
+	/// If TELL_ASSERT_SINGLE_WRITE is defined, the output is emitted without allocation via
+	/// a single write(2), followed by a best-effort symbolized stacktrace (see assertion_output.hpp)
+	///
+	/// If the frames were truncated by the site's capture_depth, the stacktrace is marked as such
+	///
+	/// This is separate from report_assertion_failure() so that the cost of the output can be benchmarked
+	template <typename Frames>
+	inline void output_assertion_failure(char const   * prm_expr,     ///< The assertion expression that has failed
+	                                     char const   * prm_msg,      ///< The message associated with the assertion or nullptr if none
+	                                     char const   * prm_function, ///< The name of the function containing the assertion
+	                                     char const   * prm_file,     ///< The name of the file containing the assertion
+	                                     int64_t        prm_line,     ///< The line number on which the assertion appears
+	                                     const Frames  &prm_frames    ///< The frames of the stack at the assertion (a raw_frames_t or bounded_stacktrace)
+	                                     ) {
+#if defined( TELL_ASSERT_SINGLE_WRITE )
+		emit_assertion_failure(
+			prm_expr,
+			prm_msg,
+			prm_function,
+			prm_file,
+			prm_line,
+			prm_frames
+		);
+#else
+		::std::string frames_description = to_string_unstripped( prm_frames );
+		if ( prm_frames.is_truncated() ) {
+			string_sink sink{ frames_description };
+			write_truncation_marker( sink, prm_frames.size() );
+		}
+
 		// Output information about the failure, with frequent flushing
 		::std::cerr
 			<< "[ASSERTION ERROR] Failed assertion '" << ::std::flush
@@ -39,25 +92,105 @@ namespace boost {
 			<< " in '"                                << ::std::flush
 			<< prm_function
 			<< "'\nStacktrace:\n"                     << ::std::flush
-			<< ::tell::except::detail::to_string_stripped_by_prefixes(
-				::boost::stacktrace::stacktrace(),
-				prefixes_to_remove
-			) << ::std::flush;
-			abort();
+			<< frames_description                     << ::std::flush;
+#endif
 	}
 
-	/// \brief Handler for BOOST_ASSERT() failures
+	/// \brief Output a string describing the assertion failure with the specified stacktrace and then call abort()
+	///
+	/// If TELL_ENABLE_INSTRUMENTATION is defined, the failure, the specified capture time and the cost of
+	/// the output are recorded against the assertion's site (before the abort())
+	template <typename Frames>
+	[[noreturn]] inline void report_assertion_failure(char const     * prm_expr,          ///< The assertion expression that has failed
+	                                                  char const     * prm_msg,           ///< The message associated with the assertion or nullptr if none
+	                                                  char const     * prm_function,      ///< The name of the function containing the assertion
+	                                                  char const     * prm_file,          ///< The name of the file containing the assertion
+	                                                  int64_t          prm_line,          ///< The line number on which the assertion appears
+	                                                  const Frames    &prm_frames,        ///< The frames of the stack at the assertion (a raw_frames_t or bounded_stacktrace)
+	                                                  const uint64_t  &prm_capture_ns = 0 ///< The time taken to capture the frames, in nanoseconds (only used if TELL_ENABLE_INSTRUMENTATION is defined)
+	                                                  ) {
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+		const auto output_start = instrumentation_clock::now();
+		output_assertion_failure( prm_expr, prm_msg, prm_function, prm_file, prm_line, prm_frames );
+		record_assertion_failure(
+			prm_function,
+			prm_file,
+			static_cast<throw_line_value_t>( prm_line ),
+			prm_capture_ns,
+			prm_frames.size(),
+			nanoseconds_since( output_start )
+		);
+#else
+		::boost::ignore_unused( prm_capture_ns );
+		output_assertion_failure( prm_expr, prm_msg, prm_function, prm_file, prm_line, prm_frames );
+#endif
+		abort();
+	}
+
+	/// \brief Capture the stack, output a string describing the assertion failure and then call abort()
+	///
+	/// The frames skipped and the maximum depth captured are governed by the site's capture_depth (see capture_policy.hpp)
+	///
+	/// If TELL_ENABLE_INSTRUMENTATION is defined, the capture is timed for report_assertion_failure() to record
+	///
+	/// This is forced inline so that the caller's frame is the first one captured (and skipped)
+	[[noreturn]] BOOST_FORCEINLINE void capture_and_report_assertion_failure(char const * prm_expr,     ///< The assertion expression that has failed
+	                                                                         char const * prm_msg,      ///< The message associated with the assertion or nullptr if none
+	                                                                         char const * prm_function, ///< The name of the function containing the assertion
+	                                                                         char const * prm_file,     ///< The name of the file containing the assertion
+	                                                                         int64_t      prm_line      ///< The line number on which the assertion appears
+	                                                                         ) {
+		const auto depth         = get_site_capture_depth( prm_file, static_cast<throw_line_value_t>( prm_line ) );
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+		const auto capture_start = instrumentation_clock::now();
+		const auto frames        = capture_assertion_frames( 1 + depth.get_skip(), max_depth_to_capture( depth ) );
+		report_assertion_failure( prm_expr, prm_msg, prm_function, prm_file, prm_line, frames, nanoseconds_since( capture_start ) );
+#else
+		report_assertion_failure( prm_expr, prm_msg, prm_function, prm_file, prm_line, capture_assertion_frames( 1 + depth.get_skip(), max_depth_to_capture( depth ) ) );
+#endif
+	}
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+namespace boost {
+
+	/// \brief Handler for BOOST_ASSERT_MSG() failures
 	///
-	/// This is implemented through a call to BOOST_ASSERT_MSG() with nullptr for the message.
+	/// This outputs a string describing the assertion failure with a stacktrace context
+	/// and then call abort() (which may result in a core dump, depending on system settings)
+	///
+	/// This is never inlined so that it's always exactly one frame, which the capture skips
+	/// (so the stacktrace needn't be symbolized to strip it)
+	BOOST_NOINLINE inline void assertion_failed_msg(char const * prm_expr,     ///< The assertion expression that has failed
+	                                                char const * prm_msg,      ///< The message associated with the assertion or nullptr if none
+	                                                char const * prm_function, ///< The name of the function containing the assertion
+	                                                char const * prm_file,     ///< The name of the file containing the assertion
+	                                                int64_t      prm_line      ///< The line number on which the assertion appears
+	                                                ) {
+		::tell::except::detail::capture_and_report_assertion_failure(
+			prm_expr,
+			prm_msg,
+			prm_function,
+			prm_file,
+			prm_line
+		);
+	}
+
+	/// \brief Handler for BOOST_ASSERT() failures
 	///
 	/// This outputs a string describing the assertion failure with a stacktrace context
 	/// and then call abort() (which may result in a core dump, depending on system settings)
-	inline void assertion_failed(char const * prm_expr,     ///< The assertion expression that has failed
-	                             char const * prm_function, ///< The name of the function containing the assertion
-	                             char const * prm_file,     ///< The name of the file containing the assertion
-	                             int64_t      prm_line      ///< The line number on which the assertion appears
-	                             ) {
-		::boost::assertion_failed_msg(
+	///
+	/// This is never inlined so that it's always exactly one frame, which the capture skips
+	/// (so the stacktrace needn't be symbolized to strip it)
+	BOOST_NOINLINE inline void assertion_failed(char const * prm_expr,     ///< The assertion expression that has failed
+	                                            char const * prm_function, ///< The name of the function containing the assertion
+	                                            char const * prm_file,     ///< The name of the file containing the assertion
+	                                            int64_t      prm_line      ///< The line number on which the assertion appears
+	                                            ) {
+		::tell::except::detail::capture_and_report_assertion_failure(
 			prm_expr,
 			nullptr,
 			prm_function,
@@ -0,0 +1,498 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_CAPTURE_POLICY_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_CAPTURE_POLICY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tell/detail/types.hpp"
+
+namespace tell { namespace except {
+
+	/// \brief A policy for how often TELL_THROW() should capture a stacktrace at a given throw site
+	///
+	/// Capturing a stacktrace means unwinding the stack, which is a waste at sites that throw in a tight
+	/// loop under expected error conditions. Whatever the policy, the function, file and line are always attached.
+	///
+	/// A policy packs into a single 64-bit value so that throw sites can read it with one atomic load.
+	///
+	/// The throws that EVERY_NTH and FIRST_N count are those since the policy was installed at the site.
+	class capture_policy final {
+	public:
+		/// \brief The kinds of policy
+		enum class kind : uint8_t {
+			ALWAYS,             ///< Capture on every throw
+			EVERY_NTH,          ///< Capture on the first throw and every limit-th throw thereafter
+			AT_MOST_PER_SECOND, ///< Capture on at most limit throws in any one second
+			FIRST_N             ///< Capture on the first limit throws and never thereafter
+		};
+
+	private:
+		/// \brief The kind of policy
+		kind     policy_kind;
+
+		/// \brief The limit associated with the kind (unused for ALWAYS)
+		uint64_t limit;
+
+		/// \brief The maximum value for limit (so that it can be packed with the kind)
+		static constexpr uint64_t max_limit = ( static_cast<uint64_t>( 1 ) << 56 ) - 1;
+
+		/// \brief Ctor from the kind and limit
+		constexpr capture_policy(const kind     &prm_kind, ///< The kind of policy
+		                         const uint64_t &prm_limit ///< The limit associated with the kind
+		                         ) : policy_kind{ prm_kind                                        },
+		                             limit      { ( prm_limit < max_limit ) ? prm_limit : max_limit } {
+		}
+
+	public:
+		/// \brief Make a policy to capture on every throw (the default)
+		static constexpr capture_policy always() {
+			return { kind::ALWAYS, 0 };
+		}
+
+		/// \brief Make a policy to capture on the first throw and every prm_n-th throw thereafter
+		static constexpr capture_policy every_nth(const uint64_t &prm_n ///< The period of the captures (where 0 is treated as 1)
+		                                          ) {
+			return { kind::EVERY_NTH, ( prm_n == 0 ) ? 1 : prm_n };
+		}
+
+		/// \brief Make a policy to capture on at most prm_k throws in any one second
+		static constexpr capture_policy at_most_per_second(const uint64_t &prm_k ///< The maximum number of captures per second
+		                                                   ) {
+			return { kind::AT_MOST_PER_SECOND, prm_k };
+		}
+
+		/// \brief Make a policy to capture on the first prm_m throws and never thereafter
+		static constexpr capture_policy first_n(const uint64_t &prm_m ///< The number of throws on which to capture
+		                                        ) {
+			return { kind::FIRST_N, prm_m };
+		}
+
+		/// \brief The kind of policy
+		constexpr kind get_kind() const {
+			return policy_kind;
+		}
+
+		/// \brief The limit associated with the kind (unused for ALWAYS)
+		constexpr uint64_t get_limit() const {
+			return limit;
+		}
+
+		/// \brief Pack this policy into a single 64-bit value
+		constexpr uint64_t pack() const {
+			return ( limit << 8 ) | static_cast<uint64_t>( policy_kind );
+		}
+
+		/// \brief Unpack a policy from a value previously generated by pack()
+		static constexpr capture_policy unpack(const uint64_t &prm_packed ///< The packed value
+		                                       ) {
+			return { static_cast<kind>( prm_packed & 0xFFu ), prm_packed >> 8 };
+		}
+	};
+
+	/// \brief Generate a string describing the specified capture_policy
+	inline ::std::string to_string(const capture_policy &prm_policy ///< The policy to describe
+	                               ) {
+		const auto limit_str = ::std::to_string( prm_policy.get_limit() );
+		switch ( prm_policy.get_kind() ) {
+			case capture_policy::kind::ALWAYS             : { return "always";                                }
+			case capture_policy::kind::EVERY_NTH          : { return "every " + limit_str + " throws";         }
+			case capture_policy::kind::AT_MOST_PER_SECOND : { return "at most " + limit_str + " per second";   }
+			case capture_policy::kind::FIRST_N            : { return "first " + limit_str + " throws only";    }
+		}
+		return "unknown";
+	}
+
+	/// \brief A policy for which frames of the stack are captured when a stacktrace is captured
+	///
+	/// Frames are counted from the innermost (where the exception is thrown or the assertion fails),
+	/// after excluding tell's own frames, which are never captured. The first skip frames are dropped
+	/// and at most max_depth frames are kept after that.
+	///
+	/// The unwinder is stopped as soon as it has found enough frames, so the cost of capturing is
+	/// bounded by the max_depth, however deep the stack. If there were more frames, the stacktrace
+	/// is marked as truncated (and rendered as such).
+	///
+	/// Like capture_policy, this packs into a single 64-bit value.
+	class capture_depth final {
+	private:
+		/// \brief The number of (innermost) frames to skip
+		uint32_t skip;
+
+		/// \brief The maximum number of frames to keep after skipping (or unlimited_depth)
+		uint32_t max_depth;
+
+		/// \brief The max_depth value that means there's no limit
+		static constexpr uint32_t unlimited_depth = ::std::numeric_limits<uint32_t>::max();
+
+	public:
+		/// \brief Ctor from the number of frames to skip and the maximum number of frames to keep
+		///
+		/// To skip frames without limiting the depth, use unlimited().with_skip()
+		constexpr capture_depth(const uint32_t &prm_skip,     ///< The number of (innermost) frames to skip
+		                        const uint32_t &prm_max_depth ///< The maximum number of frames to keep after skipping
+		                        ) : skip     { prm_skip      },
+		                            max_depth{ prm_max_depth } {
+		}
+
+		/// \brief Make a depth that keeps every frame (the default)
+		static constexpr capture_depth unlimited() {
+			return { 0, ::std::numeric_limits<uint32_t>::max() };
+		}
+
+		/// \brief Make a depth that keeps at most the innermost prm_max_depth frames
+		static constexpr capture_depth at_most(const uint32_t &prm_max_depth ///< The maximum number of frames to keep
+		                                       ) {
+			return { 0, prm_max_depth };
+		}
+
+		/// \brief Make a copy of this depth that skips the specified number of (innermost) frames
+		constexpr capture_depth with_skip(const uint32_t &prm_skip ///< The number of (innermost) frames to skip
+		                                  ) const {
+			return { prm_skip, max_depth };
+		}
+
+		/// \brief The number of (innermost) frames to skip
+		constexpr uint32_t get_skip() const {
+			return skip;
+		}
+
+		/// \brief The maximum number of frames to keep after skipping (only meaningful if is_limited())
+		constexpr uint32_t get_max_depth() const {
+			return max_depth;
+		}
+
+		/// \brief Whether there's a limit on the number of frames kept
+		constexpr bool is_limited() const {
+			return ( max_depth != unlimited_depth );
+		}
+
+		/// \brief Pack this depth into a single 64-bit value
+		constexpr uint64_t pack() const {
+			return ( static_cast<uint64_t>( skip ) << 32 ) | max_depth;
+		}
+
+		/// \brief Unpack a depth from a value previously generated by pack()
+		static constexpr capture_depth unpack(const uint64_t &prm_packed ///< The packed value
+		                                      ) {
+			return { static_cast<uint32_t>( prm_packed >> 32 ), static_cast<uint32_t>( prm_packed & 0xFFFFFFFFu ) };
+		}
+	};
+
+	/// \brief Generate a string describing the specified capture_depth
+	inline ::std::string to_string(const capture_depth &prm_depth ///< The depth to describe
+	                               ) {
+		return "skip " + ::std::to_string( prm_depth.get_skip() ) + ", "
+			+ ( prm_depth.is_limited() ? "at most " + ::std::to_string( prm_depth.get_max_depth() ) + " frames" : "all frames" );
+	}
+
+	namespace detail {
+
+		/// \brief Less-than comparator of (file, line) site keys, which can also compare with a (const char *, line) key
+		///
+		/// This allows a site to be looked up in a map by its __FILE__ without constructing a std::string
+		struct site_key_less final {
+			/// \brief Mark this as transparent so that std::map's heterogeneous find() is enabled
+			using is_transparent = void;
+
+			/// \brief Compare the specified file and line to the specified file and line
+			static bool less(const char               * const prm_lhs_file, ///< The file of the LHS
+			                 const throw_line_value_t &prm_lhs_line,        ///< The line of the LHS
+			                 const char               * const prm_rhs_file, ///< The file of the RHS
+			                 const throw_line_value_t &prm_rhs_line         ///< The line of the RHS
+			                 ) {
+				const int file_comparison = ::std::strcmp( prm_lhs_file, prm_rhs_file );
+				return ( file_comparison != 0 ) ? ( file_comparison < 0 ) : ( prm_lhs_line < prm_rhs_line );
+			}
+
+			/// \brief Compare two stored keys
+			bool operator()(const ::std::pair<::std::string, throw_line_value_t> &prm_lhs, ///< The LHS
+			                const ::std::pair<::std::string, throw_line_value_t> &prm_rhs  ///< The RHS
+			                ) const {
+				return prm_lhs < prm_rhs;
+			}
+
+			/// \brief Compare a stored key to a lookup key
+			bool operator()(const ::std::pair<::std::string, throw_line_value_t>  &prm_lhs, ///< The LHS
+			                const ::std::pair<const char *, throw_line_value_t>   &prm_rhs  ///< The RHS
+			                ) const {
+				return less( prm_lhs.first.c_str(), prm_lhs.second, prm_rhs.first, prm_rhs.second );
+			}
+
+			/// \brief Compare a lookup key to a stored key
+			bool operator()(const ::std::pair<const char *, throw_line_value_t>   &prm_lhs, ///< The LHS
+			                const ::std::pair<::std::string, throw_line_value_t>  &prm_rhs  ///< The RHS
+			                ) const {
+				return less( prm_lhs.first, prm_lhs.second, prm_rhs.first.c_str(), prm_rhs.second );
+			}
+		};
+
+		/// \brief The capture_policy and capture_depth resolved for a site, packed, with the registry generation to which they correspond
+		struct resolved_site_capture final {
+			/// \brief The site's capture_policy, packed by capture_policy::pack()
+			uint64_t packed_policy;
+
+			/// \brief The site's capture_depth, packed by capture_depth::pack()
+			uint64_t packed_depth;
+
+			/// \brief The registry generation to which the policy and depth correspond
+			uint64_t generation;
+		};
+
+		/// \brief Type alias for a map from (file, line) site keys to per-site overrides
+		template <typename T>
+		using site_map = ::std::map<::std::pair<::std::string, throw_line_value_t>, T, site_key_less>;
+
+		/// \brief Find the value for the specified site in the specified per-site map, or return the specified default
+		template <typename T>
+		const T & find_site_or_default(const site_map<T>        &prm_site_values, ///< The per-site values
+		                               const char               * const prm_file, ///< The file of the site
+		                               const throw_line_value_t &prm_line,        ///< The line of the site
+		                               const T                  &prm_default      ///< The value for sites not in the map
+		                               ) {
+			const auto find_itr = prm_site_values.find( ::std::make_pair( prm_file, prm_line ) );
+			return ( find_itr != prm_site_values.end() ) ? find_itr->second : prm_default;
+		}
+
+		/// \brief An immutable copy of the default capture_depth and the per-site overrides, published for lock-free reads
+		struct published_depths final {
+			/// \brief The depth for sites without an override, packed by capture_depth::pack()
+			uint64_t                packed_default_depth;
+
+			/// \brief The per-site depth overrides, keyed by (file, line)
+			site_map<capture_depth> site_depths;
+		};
+
+		/// \brief The process-wide registry of capture policies and capture depths: a default of each plus any per-site overrides
+		///
+		/// Throw sites cache their resolved policy and depth and only re-resolve (under the lock) when the
+		/// generation has changed, so the common case is a single relaxed atomic load.
+		///
+		/// Assertion sites have nowhere to cache a resolution and mustn't take a lock (an assertion may fail
+		/// while the lock is held) so the depths are also published as an immutable published_depths that
+		/// can be read without any lock.
+		class capture_policy_registry final {
+		private:
+			/// \brief Mutex to protect default_policy, site_policies, default_depth and site_depths
+			::std::mutex mutex;
+
+			/// \brief The policy for sites without an override
+			capture_policy default_policy = capture_policy::always();
+
+			/// \brief The per-site policy overrides, keyed by (file, line)
+			site_map<capture_policy> site_policies;
+
+			/// \brief The depth for sites without an override
+			capture_depth default_depth = capture_depth::unlimited();
+
+			/// \brief The per-site depth overrides, keyed by (file, line)
+			site_map<capture_depth> site_depths;
+
+			/// \brief A counter that's incremented on every change
+			::std::atomic<uint64_t> generation{ 0 };
+
+			/// \brief Every published_depths that has been published
+			///
+			/// These are never freed (until the registry is) because a lock-free reader may still be reading
+			/// an old one. Depths are configuration, set a handful of times, so the cost is negligible.
+			::std::vector<::std::unique_ptr<const published_depths>> all_published_depths;
+
+			/// \brief The latest published_depths
+			::std::atomic<const published_depths *> latest_published_depths{ nullptr };
+
+			/// \brief Publish a copy of the current default depth and per-site depths for lock-free reads
+			///
+			/// The mutex must be held by the caller
+			void publish_depths_locked() {
+				all_published_depths.push_back( ::std::make_unique<const published_depths>( published_depths{ default_depth.pack(), site_depths } ) );
+				latest_published_depths.store( all_published_depths.back().get(), ::std::memory_order_release );
+			}
+
+			/// \brief Publish a copy of the current default depth and per-site depths for lock-free reads
+			void publish_depths() {
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				publish_depths_locked();
+			}
+
+			/// \brief Set the value for the site at the specified file and line in the specified per-site map
+			template <typename T>
+			void set_site(site_map<T>                &prm_site_values, ///< The per-site values
+			              const ::std::string        &prm_file,        ///< The file of the site (as spelled by __FILE__ at the site)
+			              const throw_line_value_t   &prm_line,        ///< The line of the site
+			              const T                    &prm_value        ///< The value
+			              ) {
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				prm_site_values.erase( ::std::make_pair( prm_file, prm_line ) );
+				prm_site_values.emplace( ::std::make_pair( prm_file, prm_line ), prm_value );
+				++generation;
+			}
+
+		public:
+			/// \brief Default ctor, which publishes the initial depths
+			capture_policy_registry() {
+				publish_depths();
+			}
+
+			/// \brief Set the policy for sites without an override
+			void set_default(const capture_policy &prm_policy ///< The policy
+			                 ) {
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				default_policy = prm_policy;
+				++generation;
+			}
+
+			/// \brief Set the depth for sites without an override
+			void set_default(const capture_depth &prm_depth ///< The depth
+			                 ) {
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				default_depth = prm_depth;
+				++generation;
+				publish_depths_locked();
+			}
+
+			/// \brief Set the policy for the site at the specified file and line
+			void set(const ::std::string        &prm_file,  ///< The file of the site (as spelled by __FILE__ at the site)
+			         const throw_line_value_t   &prm_line,  ///< The line of the site
+			         const capture_policy       &prm_policy ///< The policy
+			         ) {
+				set_site( site_policies, prm_file, prm_line, prm_policy );
+			}
+
+			/// \brief Set the depth for the site at the specified file and line
+			void set(const ::std::string        &prm_file, ///< The file of the site (as spelled by __FILE__ at the site)
+			         const throw_line_value_t   &prm_line, ///< The line of the site
+			         const capture_depth        &prm_depth ///< The depth
+			         ) {
+				set_site( site_depths, prm_file, prm_line, prm_depth );
+				publish_depths();
+			}
+
+			/// \brief Remove all per-site policy overrides
+			void clear_sites() {
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				site_policies.clear();
+				++generation;
+			}
+
+			/// \brief Remove all per-site depth overrides
+			void clear_site_depths() {
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				site_depths.clear();
+				++generation;
+				publish_depths_locked();
+			}
+
+			/// \brief Get the current generation
+			uint64_t get_generation() const {
+				return generation.load( ::std::memory_order_acquire );
+			}
+
+			/// \brief Resolve the policy and depth for the site at the specified file and line and pass them to the specified function
+			///
+			/// The function is called with the mutex held so that concurrent resolutions for the same site (each of which
+			/// may publish its result in several stores) are serialized and a later one can't be overwritten by an earlier one.
+			///
+			/// This doesn't allocate
+			template <typename Fn>
+			void resolve(const char               * const prm_file, ///< The file of the site
+			             const throw_line_value_t &prm_line,        ///< The line of the site
+			             Fn                      &&prm_fn           ///< The function to be passed the resolved_site_capture
+			             ) {
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				prm_fn( resolved_site_capture{
+					find_site_or_default( site_policies, prm_file, prm_line, default_policy ).pack(),
+					find_site_or_default( site_depths,   prm_file, prm_line, default_depth  ).pack(),
+					generation.load()
+				} );
+			}
+
+			/// \brief Get the depth for the site at the specified file and line from the latest published_depths
+			///
+			/// This takes no lock and doesn't allocate
+			capture_depth lock_free_depth(const char               * const prm_file, ///< The file of the site
+			                              const throw_line_value_t &prm_line         ///< The line of the site
+			                              ) const noexcept {
+				const published_depths &the_depths = *latest_published_depths.load( ::std::memory_order_acquire );
+				const auto find_itr = the_depths.site_depths.find( ::std::make_pair( prm_file, prm_line ) );
+				return ( find_itr != the_depths.site_depths.end() ) ? find_itr->second : capture_depth::unpack( the_depths.packed_default_depth );
+			}
+
+			/// \brief Get the process-wide capture_policy_registry
+			static capture_policy_registry & instance() {
+				static capture_policy_registry the_instance;
+				return the_instance;
+			}
+		};
+
+		/// \brief Convert the specified capture_depth's max_depth to a value to pass to the frame capture functions
+		inline size_t max_depth_to_capture(const capture_depth &prm_depth ///< The capture_depth
+		                                   ) {
+			return prm_depth.is_limited() ? static_cast<size_t>( prm_depth.get_max_depth() ) : static_cast<size_t>( -1 );
+		}
+
+		/// \brief Get the capture_depth for the site at the specified file and line
+		///
+		/// This is for sites (like assertions) that don't cache it in a throw_site. It takes no lock and
+		/// doesn't allocate so it's safe to call while failing an assertion (even one within tell).
+		inline capture_depth get_site_capture_depth(const char               * const prm_file, ///< The file of the site
+		                                            const throw_line_value_t &prm_line         ///< The line of the site
+		                                            ) noexcept {
+			return capture_policy_registry::instance().lock_free_depth( prm_file, prm_line );
+		}
+
+	} // namespace detail
+
+	/// \brief Set the capture_policy for all TELL_THROW() sites that don't have their own
+	inline void set_default_capture_policy(const capture_policy &prm_policy ///< The policy
+	                                       ) {
+		detail::capture_policy_registry::instance().set_default( prm_policy );
+	}
+
+	/// \brief Set the capture_policy for the TELL_THROW() site at the specified file and line
+	///
+	/// The file must match the __FILE__ of the site exactly (ie as passed to the compiler)
+	inline void set_capture_policy(const ::std::string                &prm_file,  ///< The file of the site
+	                               const detail::throw_line_value_t   &prm_line,  ///< The line of the site
+	                               const capture_policy               &prm_policy ///< The policy
+	                               ) {
+		detail::capture_policy_registry::instance().set( prm_file, prm_line, prm_policy );
+	}
+
+	/// \brief Remove the capture_policy of every TELL_THROW() site that has its own, so they use the default
+	inline void clear_site_capture_policies() {
+		detail::capture_policy_registry::instance().clear_sites();
+	}
+
+	/// \brief Set the capture_depth for all TELL_THROW() and assertion sites that don't have their own
+	inline void set_default_capture_depth(const capture_depth &prm_depth ///< The depth
+	                                      ) {
+		detail::capture_policy_registry::instance().set_default( prm_depth );
+	}
+
+	/// \brief Set the capture_depth for the TELL_THROW() or assertion site at the specified file and line
+	///
+	/// The file must match the __FILE__ of the site exactly (ie as passed to the compiler)
+	inline void set_capture_depth(const ::std::string                &prm_file, ///< The file of the site
+	                              const detail::throw_line_value_t   &prm_line, ///< The line of the site
+	                              const capture_depth                &prm_depth ///< The depth
+	                              ) {
+		detail::capture_policy_registry::instance().set( prm_file, prm_line, prm_depth );
+	}
+
+	/// \brief Remove the capture_depth of every site that has its own, so they use the default
+	inline void clear_site_capture_depths() {
+		detail::capture_policy_registry::instance().clear_site_depths();
+	}
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_CAPTURE_POLICY_HPP
@@ -0,0 +1,87 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_BOUNDED_STACKTRACE_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_BOUNDED_STACKTRACE_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#include <boost/stacktrace.hpp>
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief A boost::stacktrace::stacktrace captured with a maximum depth, which records whether the stack was deeper
+	///
+	/// This offers the same interface as raw_frames (so code can handle either).
+	///
+	/// If the stack was deeper than the maximum depth, the stacktrace holds one frame more than is kept
+	/// (the one that detected the truncation); rather than copying the kept frames into a new stacktrace,
+	/// that frame is just excluded from size(), begin() and end().
+	class bounded_stacktrace final {
+	private:
+		/// \brief The captured stacktrace (which may have one more frame than is kept)
+		::boost::stacktrace::stacktrace the_stacktrace;
+
+		/// \brief The number of frames kept
+		size_t num_frames = 0;
+
+		/// \brief Ctor from the stacktrace and the number of its frames to keep
+		bounded_stacktrace(::boost::stacktrace::stacktrace  prm_stacktrace, ///< The captured stacktrace
+		                   const size_t                    &prm_num_frames  ///< The number of frames to keep
+		                   ) : the_stacktrace{ ::std::move( prm_stacktrace ) },
+		                       num_frames    { prm_num_frames                } {
+		}
+
+	public:
+		/// \brief Type alias for the const_iterator type
+		using const_iterator = ::boost::stacktrace::stacktrace::const_iterator;
+
+		/// \brief Capture the current call stack, with the function that calls this as the first frame
+		///
+		/// The unwinding stops after one frame more than will be kept (which is just used to detect truncation),
+		/// so the cost is bounded by the maximum depth rather than by the depth of the stack.
+		///
+		/// This is forced inline so that, like boost::stacktrace::stacktrace(), the first frame is the caller
+		BOOST_FORCEINLINE static bounded_stacktrace capture(const size_t &prm_skip,                                 ///< The number of (innermost) frames to skip
+		                                                    const size_t &prm_max_depth = static_cast<size_t>( -1 ) ///< The maximum number of frames to keep after skipping
+		                                                    ) {
+			if ( prm_max_depth == static_cast<size_t>( -1 ) ) {
+				::boost::stacktrace::stacktrace result( prm_skip, prm_max_depth );
+				const size_t num_captured = result.size();
+				return { ::std::move( result ), num_captured };
+			}
+			::boost::stacktrace::stacktrace result( prm_skip, prm_max_depth + 1 );
+			const size_t num_captured = result.size();
+			return { ::std::move( result ), ( num_captured < prm_max_depth ) ? num_captured : prm_max_depth };
+		}
+
+		/// \brief The number of frames stored
+		size_t size() const noexcept {
+			return num_frames;
+		}
+
+		/// \brief Whether the stack had more frames than were kept
+		bool is_truncated() const noexcept {
+			return ( the_stacktrace.size() > num_frames );
+		}
+
+		/// \brief Whether no frames are stored
+		bool empty() const noexcept {
+			return ( num_frames == 0 );
+		}
+
+		/// \brief Standard const begin() operator
+		const_iterator begin() const noexcept {
+			return the_stacktrace.begin();
+		}
+
+		/// \brief Standard const end() operator
+		const_iterator end() const noexcept {
+			return ::std::next( the_stacktrace.begin(), static_cast<ptrdiff_t>( num_frames ) );
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_BOUNDED_STACKTRACE_HPP
@@ -0,0 +1,170 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_BYTE_READER_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_BYTE_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief A bounds-checked reader of native-endian values from a region of bytes
+	///
+	/// Rather than throwing on an attempt to read beyond the end, this records the failure
+	/// (queryable via ok()) and returns zero values, so that callers can check once after
+	/// a batch of reads.
+	class byte_reader final {
+	private:
+		/// \brief The current read position
+		const unsigned char * cursor  = nullptr;
+
+		/// \brief One past the last readable byte
+		const unsigned char * end_ptr = nullptr;
+
+		/// \brief Whether any read has failed
+		bool failed = false;
+
+		/// \brief Return whether the specified number of bytes can be read, recording a failure if not
+		bool can_read(const size_t &prm_num_bytes ///< The number of bytes to be read
+		              ) {
+			if ( failed || static_cast<size_t>( end_ptr - cursor ) < prm_num_bytes ) {
+				failed = true;
+				return false;
+			}
+			return true;
+		}
+
+	public:
+		byte_reader() noexcept = default;
+
+		/// \brief Ctor from the region of bytes to read
+		byte_reader(const unsigned char * const prm_begin,     ///< The start of the region
+		            const size_t                &prm_num_bytes ///< The number of bytes in the region
+		            ) noexcept : cursor { prm_begin                 },
+		                         end_ptr{ prm_begin + prm_num_bytes } {
+		}
+
+		/// \brief Whether all reads so far have succeeded
+		bool ok() const noexcept {
+			return ! failed;
+		}
+
+		/// \brief Whether all the bytes have been read (or a read has failed)
+		bool at_end() const noexcept {
+			return failed || cursor >= end_ptr;
+		}
+
+		/// \brief The current read position
+		const unsigned char * position() const noexcept {
+			return cursor;
+		}
+
+		/// \brief The number of bytes remaining
+		size_t remaining() const noexcept {
+			return failed ? 0 : static_cast<size_t>( end_ptr - cursor );
+		}
+
+		/// \brief Make a reader of the next specified number of bytes and skip over them in this reader
+		byte_reader sub_reader(const size_t &prm_num_bytes ///< The number of bytes for the sub-reader
+		                       ) {
+			if ( ! can_read( prm_num_bytes ) ) {
+				return {};
+			}
+			const byte_reader result{ cursor, prm_num_bytes };
+			cursor += prm_num_bytes;
+			return result;
+		}
+
+		/// \brief Skip the specified number of bytes
+		void skip(const size_t &prm_num_bytes ///< The number of bytes to skip
+		          ) {
+			if ( can_read( prm_num_bytes ) ) {
+				cursor += prm_num_bytes;
+			}
+		}
+
+		/// \brief Read a fixed-size, native-endian value of type T
+		template <typename T>
+		T read() {
+			static_assert( ::std::is_trivially_copyable<T>::value, "byte_reader can only read trivially copyable types" );
+			T result{};
+			if ( can_read( sizeof( T ) ) ) {
+				::std::memcpy( &result, cursor, sizeof( T ) );
+				cursor += sizeof( T );
+			}
+			return result;
+		}
+
+		/// \brief Read an unsigned value of the specified size in bytes (1, 2, 4 or 8)
+		uint64_t read_unsigned(const size_t &prm_num_bytes ///< The size of the value in bytes
+		                       ) {
+			switch ( prm_num_bytes ) {
+				case 1  : { return read<uint8_t >(); }
+				case 2  : { return read<uint16_t>(); }
+				case 4  : { return read<uint32_t>(); }
+				case 8  : { return read<uint64_t>(); }
+				default : {
+					failed = true;
+					return 0;
+				}
+			}
+		}
+
+		/// \brief Read an unsigned LEB128 value
+		uint64_t read_uleb128() {
+			uint64_t result = 0;
+			unsigned shift  = 0;
+			while ( can_read( 1 ) ) {
+				const unsigned char byte = *cursor++;
+				if ( shift < 64 ) {
+					result |= ( static_cast<uint64_t>( byte & 0x7Fu ) << shift );
+				}
+				shift += 7;
+				if ( ( byte & 0x80u ) == 0 ) {
+					break;
+				}
+			}
+			return result;
+		}
+
+		/// \brief Read a signed LEB128 value
+		int64_t read_sleb128() {
+			uint64_t      result = 0;
+			unsigned      shift  = 0;
+			unsigned char byte   = 0;
+			while ( can_read( 1 ) ) {
+				byte = *cursor++;
+				if ( shift < 64 ) {
+					result |= ( static_cast<uint64_t>( byte & 0x7Fu ) << shift );
+				}
+				shift += 7;
+				if ( ( byte & 0x80u ) == 0 ) {
+					break;
+				}
+			}
+			if ( shift < 64 && ( byte & 0x40u ) != 0 ) {
+				result |= ( ~static_cast<uint64_t>( 0 ) << shift );
+			}
+			return static_cast<int64_t>( result );
+		}
+
+		/// \brief Read a null-terminated string, returning a pointer into the region (or "" on failure)
+		const char * read_cstring() {
+			const auto null_ptr = static_cast<const unsigned char *>(
+				failed ? nullptr : ::std::memchr( cursor, '\0', static_cast<size_t>( end_ptr - cursor ) )
+			);
+			if ( null_ptr == nullptr ) {
+				failed = true;
+				return "";
+			}
+			const auto result = reinterpret_cast<const char *>( cursor );
+			cursor = null_ptr + 1;
+			return result;
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_BYTE_READER_HPP
@@ -0,0 +1,86 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_CAPTURED_FRAMES_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_CAPTURED_FRAMES_HPP
+
+#include <cstddef>
+
+#include <boost/exception/get_error_info.hpp>
+#include <boost/optional.hpp>
+
+#include "tell/capture_policy.hpp"
+#include "tell/detail/bounded_stacktrace.hpp"
+#include "tell/detail/raw_frames.hpp"
+#include "tell/detail/throw_record.hpp"
+#include "tell/detail/types.hpp"
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief Call the specified function with the throw_record that TELL_THROW() attached to the specified exception
+	///
+	/// The function is passed either a throw_record<bounded_stacktrace> or a throw_record<raw_frames_t> (depending
+	/// on whether TELL_USE_RAW_FRAMES was defined at the throw site) so must accept either. Callers that need several
+	/// of the record's items should get them all from here rather than with separate lookups.
+	///
+	/// \returns Whether there was a throw_record (and hence whether the function was called)
+	template <typename Ex, typename Fn>
+	bool visit_throw_record(const Ex  &prm_exception, ///< The exception to query
+	                        Fn       &&prm_fn         ///< The function to call with the throw_record
+	                        ) {
+		if ( const auto * const record_ptr = ::boost::get_error_info< boost_exception_stacktrace_record_error_info >( prm_exception ) ) {
+			prm_fn( *record_ptr );
+			return true;
+		}
+		if ( const auto * const record_ptr = ::boost::get_error_info< boost_exception_raw_frames_record_error_info >( prm_exception ) ) {
+			prm_fn( *record_ptr );
+			return true;
+		}
+		return false;
+	}
+
+	/// \brief Call the specified function with the frames that TELL_THROW() captured in the specified exception
+	///
+	/// The function is passed either a bounded_stacktrace or a raw_frames_t (depending on whether
+	/// TELL_USE_RAW_FRAMES was defined at the throw site) so must accept either. Use frame_address()
+	/// to get the address of each of the elements.
+	///
+	/// \returns Whether there were any captured frames (and hence whether the function was called)
+	template <typename Ex, typename Fn>
+	bool visit_captured_frames(const Ex  &prm_exception, ///< The exception to query
+	                           Fn       &&prm_fn         ///< The function to call with the frames
+	                           ) {
+		bool were_captured = false;
+		visit_throw_record(
+			prm_exception,
+			[&] (const auto &x) {
+				if ( const auto * const frames_ptr = x.get_frames() ) {
+					prm_fn( *frames_ptr );
+					were_captured = true;
+				}
+			}
+		);
+		return were_captured;
+	}
+
+	/// \brief Get the number of frames kept if TELL_THROW() truncated the stacktrace it captured in the
+	///        specified exception (because the stack was deeper than the site's capture_depth allowed) or none otherwise
+	template <typename Ex>
+	::boost::optional<size_t> get_captured_frames_truncation(const Ex &prm_exception ///< The exception to query
+	                                                         ) {
+		::boost::optional<size_t> truncation;
+		visit_throw_record( prm_exception, [&] (const auto &x) { truncation = x.get_truncation(); } );
+		return truncation;
+	}
+
+	/// \brief Get the capture_policy that skipped TELL_THROW()'s stacktrace capture for the specified exception, or none if it wasn't skipped
+	template <typename Ex>
+	::boost::optional<capture_policy> get_capture_skipped_by(const Ex &prm_exception ///< The exception to query
+	                                                         ) {
+		::boost::optional<capture_policy> capture_skipped_by;
+		visit_throw_record( prm_exception, [&] (const auto &x) { capture_skipped_by = x.get_capture_skipped_by(); } );
+		return capture_skipped_by;
+	}
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_CAPTURED_FRAMES_HPP
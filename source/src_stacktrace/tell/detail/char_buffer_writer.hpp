@@ -0,0 +1,94 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_CHAR_BUFFER_WRITER_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_CHAR_BUFFER_WRITER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "tell/detail/sink_formatting.hpp"
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief A writer of text into a fixed-size char buffer, which truncates rather than overflowing
+	///
+	/// This never allocates, throws or calls into the C/C++ I/O libraries, so it's safe to use
+	/// when the heap may be corrupt or locks may be held. The result isn't null-terminated.
+	///
+	/// This is also a sink for the rendering functions (see output_sinks.hpp).
+	class char_buffer_writer final {
+	private:
+		/// \brief The start of the buffer
+		char   * buffer_ptr;
+
+		/// \brief The size of the buffer
+		size_t   capacity;
+
+		/// \brief The number of chars written so far
+		size_t   length    = 0;
+
+		/// \brief Whether any write has been truncated
+		bool     truncated = false;
+
+	public:
+		/// \brief Ctor from the buffer into which to write
+		char_buffer_writer(char         * const prm_buffer,  ///< The start of the buffer
+		                   const size_t  &prm_capacity       ///< The size of the buffer
+		                   ) noexcept : buffer_ptr{ prm_buffer   },
+		                                capacity  { prm_capacity } {
+		}
+
+		/// \brief Write the specified number of chars, truncating if there isn't room
+		char_buffer_writer & write(const char * const prm_chars,    ///< The chars to write
+		                           const size_t      &prm_num_chars ///< The number of chars to write
+		                           ) noexcept {
+			const size_t num_to_copy = ::std::min( prm_num_chars, capacity - length );
+			::std::memcpy( buffer_ptr + length, prm_chars, num_to_copy );
+			length += num_to_copy;
+			truncated = truncated || ( num_to_copy < prm_num_chars );
+			return *this;
+		}
+
+		/// \brief Write the specified null-terminated string (or "(null)" for nullptr), truncating if there isn't room
+		char_buffer_writer & write(const char * const prm_string ///< The string to write
+		                           ) noexcept {
+			::tell::except::detail::write_cstring( *this, prm_string );
+			return *this;
+		}
+
+		/// \brief Write the specified integer in decimal, right-aligned in a field of (at least) the specified width
+		char_buffer_writer & write_decimal(const int64_t &prm_value,    ///< The value to write
+		                                   const size_t  &prm_width = 0 ///< The minimum width of the field
+		                                   ) noexcept {
+			::tell::except::detail::write_decimal( *this, prm_value, prm_width );
+			return *this;
+		}
+
+		/// \brief Write the specified value as "0x" followed by 16 upper-case hex digits (matching Boost Stacktrace)
+		char_buffer_writer & write_hex(const uint64_t &prm_value ///< The value to write
+		                               ) noexcept {
+			::tell::except::detail::write_hex( *this, prm_value );
+			return *this;
+		}
+
+		/// \brief The start of the written chars
+		const char * data() const noexcept {
+			return buffer_ptr;
+		}
+
+		/// \brief The number of chars written
+		size_t size() const noexcept {
+			return length;
+		}
+
+		/// \brief Whether any write has been truncated
+		bool was_truncated() const noexcept {
+			return truncated;
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_CHAR_BUFFER_WRITER_HPP
@@ -0,0 +1,46 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_CONFIG_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_CONFIG_HPP
+
+/// \file
+/// \brief Compile-time configuration for tell
+///
+/// Each of these may be defined (eg with -D on the compile line) before any tell header is included.
+/// They must be defined consistently across all translation units in a program.
+///
+///  * TELL_USE_RAW_FRAMES          : make TELL_THROW() capture raw return addresses into a fixed-capacity
+///                                   inline buffer (with no heap allocation) rather than a boost::stacktrace::stacktrace
+///  * TELL_RAW_FRAMES_CAPACITY     : the maximum number of frames stored by the raw-frames capture (default: 64)
+///  * TELL_SYMBOL_CACHE_CAPACITY   : the initial maximum number of entries in the process-wide symbol_cache (default: 4096)
+///  * TELL_USE_ELF_SYMBOLIZER      : make stacktrace rendering symbolize with tell's in-process ELF/DWARF elf_symbolizer
+///                                   rather than the Boost Stacktrace backend (ELF platforms only)
+///  * TELL_ASSERT_SINGLE_WRITE     : make boost::assertion_failed_msg() format into a preallocated static buffer
+///                                   and emit with a single write(2) (see assertion_output.hpp)
+///  * TELL_ASSERTION_BUFFER_SIZE   : the size of the static buffer used by TELL_ASSERT_SINGLE_WRITE (default: 8192)
+///  * TELL_TRACE_REGISTRY_CAPACITY : the initial maximum number of distinct stack fingerprints tracked by the
+///                                   process-wide trace_registry (default: 65536)
+///  * TELL_ENABLE_INSTRUMENTATION  : make TELL_THROW(), exception rendering and the assertion handlers record
+///                                   per-site counts and timings (see instrumentation.hpp)
+///  * TELL_INSTRUMENTATION_SLOTS   : the number of distinct sites each thread can record with
+///                                   TELL_ENABLE_INSTRUMENTATION, which must be a power of two (default: 256)
+
+#ifndef TELL_RAW_FRAMES_CAPACITY
+#define TELL_RAW_FRAMES_CAPACITY 64
+#endif
+
+#ifndef TELL_ASSERTION_BUFFER_SIZE
+#define TELL_ASSERTION_BUFFER_SIZE 8192
+#endif
+
+#ifndef TELL_SYMBOL_CACHE_CAPACITY
+#define TELL_SYMBOL_CACHE_CAPACITY 4096
+#endif
+
+#ifndef TELL_TRACE_REGISTRY_CAPACITY
+#define TELL_TRACE_REGISTRY_CAPACITY 65536
+#endif
+
+#ifndef TELL_INSTRUMENTATION_SLOTS
+#define TELL_INSTRUMENTATION_SLOTS 256
+#endif
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_CONFIG_HPP
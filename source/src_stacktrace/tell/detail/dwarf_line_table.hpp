@@ -0,0 +1,379 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_DWARF_LINE_TABLE_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_DWARF_LINE_TABLE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tell/detail/byte_reader.hpp"
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief A sorted address->(file, line) index built from a module's DWARF .debug_line section
+	///
+	/// This supports DWARF versions 2 to 5. All the line programs in the section are run
+	/// once at construction and the resulting rows are sorted by address so that each
+	/// lookup is a binary search.
+	class dwarf_line_table final {
+	private:
+		/// \brief A single row of the line table
+		struct row final {
+			/// \brief The (module-relative) address at which this row starts
+			uint64_t address;
+
+			/// \brief The index of the row's file in files, or end_sequence_file for the end of a sequence
+			uint32_t file_index;
+
+			/// \brief The row's line number
+			uint32_t line;
+		};
+
+		/// \brief Sentinel file_index value to mark the end of a sequence (ie the start of an address gap)
+		static constexpr uint32_t end_sequence_file = ::std::numeric_limits<uint32_t>::max();
+
+		/// \brief Some DWARF constants (from the DWARF 5 standard)
+		enum : uint8_t {
+			DW_LNS_copy               = 0x01,
+			DW_LNS_advance_pc         = 0x02,
+			DW_LNS_advance_line       = 0x03,
+			DW_LNS_set_file           = 0x04,
+			DW_LNS_const_add_pc       = 0x08,
+			DW_LNS_fixed_advance_pc   = 0x09,
+
+			DW_LNE_end_sequence       = 0x01,
+			DW_LNE_set_address        = 0x02,
+
+			DW_LNCT_path              = 0x01,
+			DW_LNCT_directory_index   = 0x02,
+
+			DW_FORM_block2            = 0x03,
+			DW_FORM_block4            = 0x04,
+			DW_FORM_data2             = 0x05,
+			DW_FORM_data4             = 0x06,
+			DW_FORM_data8             = 0x07,
+			DW_FORM_string            = 0x08,
+			DW_FORM_block             = 0x09,
+			DW_FORM_block1            = 0x0a,
+			DW_FORM_data1             = 0x0b,
+			DW_FORM_sdata             = 0x0d,
+			DW_FORM_strp              = 0x0e,
+			DW_FORM_udata             = 0x0f,
+			DW_FORM_data16            = 0x1e,
+			DW_FORM_line_strp         = 0x1f,
+		};
+
+		/// \brief The distinct file paths referenced by rows
+		::std::vector<::std::string> files;
+
+		/// \brief The rows, sorted by address
+		::std::vector<row> rows;
+
+		/// \brief The sections that DW_FORM_strp and DW_FORM_line_strp values refer into
+		struct string_sections final {
+			/// \brief The .debug_str section
+			byte_reader debug_str;
+
+			/// \brief The .debug_line_str section
+			byte_reader debug_line_str;
+		};
+
+		/// \brief Read a string at the specified offset into the specified section, or "" if invalid
+		static const char * string_at(const byte_reader &prm_section, ///< The string section
+		                              const uint64_t    &prm_offset   ///< The offset of the string in the section
+		                              ) {
+			byte_reader reader = prm_section;
+			reader.skip( static_cast<size_t>( prm_offset ) );
+			return reader.read_cstring();
+		}
+
+		/// \brief Read a DWARF 5 directory/file entry attribute of the specified form, returning a
+		///        (string, number) pair, of which only the relevant part is meaningful
+		static ::std::pair<const char *, uint64_t> read_form(byte_reader           &prm_reader,   ///< The reader from which to read the value
+		                                                      const uint64_t        &prm_form,    ///< The DW_FORM of the value
+		                                                      const bool            &prm_is_64,   ///< Whether this is 64-bit DWARF
+		                                                      const string_sections &prm_sections ///< The string sections
+		                                                      ) {
+			const size_t offset_size = prm_is_64 ? 8 : 4;
+			switch ( prm_form ) {
+				case DW_FORM_string    : { return { prm_reader.read_cstring(), 0 }; }
+				case DW_FORM_strp      : { return { string_at( prm_sections.debug_str,      prm_reader.read_unsigned( offset_size ) ), 0 }; }
+				case DW_FORM_line_strp : { return { string_at( prm_sections.debug_line_str, prm_reader.read_unsigned( offset_size ) ), 0 }; }
+				case DW_FORM_data1     : { return { "", prm_reader.read_unsigned( 1 ) }; }
+				case DW_FORM_data2     : { return { "", prm_reader.read_unsigned( 2 ) }; }
+				case DW_FORM_data4     : { return { "", prm_reader.read_unsigned( 4 ) }; }
+				case DW_FORM_data8     : { return { "", prm_reader.read_unsigned( 8 ) }; }
+				case DW_FORM_udata     : { return { "", prm_reader.read_uleb128()     }; }
+				case DW_FORM_sdata     : { return { "", static_cast<uint64_t>( prm_reader.read_sleb128() ) }; }
+				case DW_FORM_data16    : { prm_reader.skip( 16                                                  ); return { "", 0 }; }
+				case DW_FORM_block1    : { prm_reader.skip( static_cast<size_t>( prm_reader.read_unsigned( 1 ) ) ); return { "", 0 }; }
+				case DW_FORM_block2    : { prm_reader.skip( static_cast<size_t>( prm_reader.read_unsigned( 2 ) ) ); return { "", 0 }; }
+				case DW_FORM_block4    : { prm_reader.skip( static_cast<size_t>( prm_reader.read_unsigned( 4 ) ) ); return { "", 0 }; }
+				case DW_FORM_block     : { prm_reader.skip( static_cast<size_t>( prm_reader.read_uleb128()     ) ); return { "", 0 }; }
+				default : {
+					// An unsupported form makes the rest of the header unreadable
+					prm_reader.skip( prm_reader.remaining() + 1 );
+					return { "", 0 };
+				}
+			}
+		}
+
+		/// \brief Join a directory and a file name into a path
+		static ::std::string join_path(const ::std::string &prm_dir, ///< The directory (which may be empty)
+		                               const ::std::string &prm_name ///< The file name (which may be absolute)
+		                               ) {
+			if ( prm_dir.empty() || ( ! prm_name.empty() && prm_name.front() == '/' ) ) {
+				return prm_name;
+			}
+			return ( prm_dir.back() == '/' ) ? ( prm_dir + prm_name ) : ( prm_dir + "/" + prm_name );
+		}
+
+		/// \brief Read a DWARF 5 directory or file-name entry table, returning (path, directory index) pairs
+		static ::std::vector<::std::pair<::std::string, uint64_t>> read_v5_entries(byte_reader           &prm_reader, ///< The reader, positioned at the entry format count
+		                                                                          const bool            &prm_is_64,   ///< Whether this is 64-bit DWARF
+		                                                                          const string_sections &prm_sections ///< The string sections
+		                                                                          ) {
+			const auto num_formats = prm_reader.read<uint8_t>();
+			::std::vector<::std::pair<uint64_t, uint64_t>> formats;
+			for (size_t format_ctr = 0; format_ctr < num_formats; ++format_ctr) {
+				const auto content_type = prm_reader.read_uleb128();
+				const auto form         = prm_reader.read_uleb128();
+				formats.emplace_back( content_type, form );
+			}
+
+			const auto num_entries = prm_reader.read_uleb128();
+			::std::vector<::std::pair<::std::string, uint64_t>> entries;
+			for (uint64_t entry_ctr = 0; entry_ctr < num_entries && prm_reader.ok(); ++entry_ctr) {
+				::std::pair<::std::string, uint64_t> entry{ "", 0 };
+				for (const auto &format : formats) {
+					const auto value = read_form( prm_reader, format.second, prm_is_64, prm_sections );
+					if ( format.first == DW_LNCT_path ) {
+						entry.first = value.first;
+					}
+					else if ( format.first == DW_LNCT_directory_index ) {
+						entry.second = value.second;
+					}
+				}
+				entries.push_back( ::std::move( entry ) );
+			}
+			return entries;
+		}
+
+		/// \brief Parse a single line-number program unit, appending its rows
+		///
+		/// Sequences that start at address 0 are discarded: these come from code that the linker
+		/// has dropped (eg duplicate inline functions) and would otherwise shadow real code.
+		void parse_unit(byte_reader                                     &prm_reader,     ///< The reader, positioned just after the unit_length
+		                const bool                                      &prm_is_64,      ///< Whether this is 64-bit DWARF
+		                const string_sections                           &prm_sections,   ///< The string sections
+		                ::std::unordered_map<::std::string, uint32_t>   &prm_file_lookup ///< A map from path to index in files, used to share paths between units
+		                ) {
+			const auto version = prm_reader.read<uint16_t>();
+			if ( version < 2 || version > 5 ) {
+				return;
+			}
+			size_t address_size = sizeof( void * );
+			if ( version >= 5 ) {
+				address_size = prm_reader.read<uint8_t>();
+				prm_reader.skip( 1 ); // segment_selector_size
+			}
+			const auto  header_length     = prm_reader.read_unsigned( prm_is_64 ? 8 : 4 );
+			byte_reader header            = prm_reader.sub_reader( static_cast<size_t>( header_length ) );
+			byte_reader program           = prm_reader;
+
+			const auto min_inst_length    = header.read<uint8_t>();
+			if ( version >= 4 ) {
+				header.skip( 1 ); // maximum_operations_per_instruction (only relevant for VLIW)
+			}
+			header.skip( 1 ); // default_is_stmt
+			const auto line_base          = header.read<int8_t >();
+			const auto line_range         = header.read<uint8_t>();
+			const auto opcode_base        = header.read<uint8_t>();
+			::std::vector<uint8_t> standard_opcode_lengths;
+			for (size_t opcode_ctr = 1; opcode_ctr < opcode_base; ++opcode_ctr) {
+				standard_opcode_lengths.push_back( header.read<uint8_t>() );
+			}
+
+			// Gather the paths of the unit's files
+			::std::vector<::std::string> unit_files;
+			if ( version >= 5 ) {
+				const auto directories = read_v5_entries( header, prm_is_64, prm_sections );
+				const auto file_names  = read_v5_entries( header, prm_is_64, prm_sections );
+				const ::std::string comp_dir = directories.empty() ? ::std::string{} : directories.front().first;
+				for (const auto &file_name : file_names) {
+					const ::std::string dir = ( file_name.second < directories.size() )
+						? join_path( comp_dir, directories[ static_cast<size_t>( file_name.second ) ].first )
+						: comp_dir;
+					unit_files.push_back( join_path( dir, file_name.first ) );
+				}
+			}
+			else {
+				::std::vector<::std::string> directories{ "" };
+				for (const char * dir = header.read_cstring(); header.ok() && *dir != '\0'; dir = header.read_cstring()) {
+					directories.emplace_back( dir );
+				}
+				// File indices are 1-based before DWARF 5, so insert an unused first entry
+				unit_files.emplace_back();
+				for (const char * name = header.read_cstring(); header.ok() && *name != '\0'; name = header.read_cstring()) {
+					const auto dir_index = header.read_uleb128();
+					header.read_uleb128(); // modification time
+					header.read_uleb128(); // file length
+					unit_files.push_back( join_path(
+						( dir_index < directories.size() ) ? directories[ static_cast<size_t>( dir_index ) ] : ::std::string{},
+						name
+					) );
+				}
+			}
+			if ( ! header.ok() || line_range == 0 ) {
+				return;
+			}
+
+			// Map the unit's file indices to indices into files
+			::std::vector<uint32_t> file_indices;
+			for (const auto &unit_file : unit_files) {
+				const auto insert_result = prm_file_lookup.emplace( unit_file, static_cast<uint32_t>( files.size() ) );
+				if ( insert_result.second ) {
+					files.push_back( unit_file );
+				}
+				file_indices.push_back( insert_result.first->second );
+			}
+			const uint32_t unknown_file_index = [&] {
+				const auto insert_result = prm_file_lookup.emplace( "", static_cast<uint32_t>( files.size() ) );
+				if ( insert_result.second ) {
+					files.emplace_back();
+				}
+				return insert_result.first->second;
+			} ();
+
+			// Run the line-number program
+			uint64_t         address        = 0;
+			uint64_t         file           = 1;
+			int64_t          line           = 1;
+			::std::vector<row> sequence_rows;
+			const auto append_row = [&] (const bool &prm_end_sequence) {
+				const uint32_t file_index = prm_end_sequence
+					? end_sequence_file
+					: ( file < file_indices.size() ) ? file_indices[ static_cast<size_t>( file ) ] : unknown_file_index;
+				sequence_rows.push_back( { address, file_index, static_cast<uint32_t>( line ) } );
+			};
+			const auto advance_address = [&] (const uint64_t &prm_operation_advance) {
+				address += min_inst_length * prm_operation_advance;
+			};
+
+			while ( ! program.at_end() ) {
+				const auto opcode = program.read<uint8_t>();
+				if ( opcode >= opcode_base ) {
+					const auto adjusted_opcode = static_cast<uint8_t>( opcode - opcode_base );
+					advance_address( adjusted_opcode / line_range );
+					line += line_base + ( adjusted_opcode % line_range );
+					append_row( false );
+				}
+				else if ( opcode == 0 ) {
+					const auto  length        = program.read_uleb128();
+					byte_reader extended      = program.sub_reader( static_cast<size_t>( length ) );
+					const auto  extended_code = extended.read<uint8_t>();
+					if ( extended_code == DW_LNE_end_sequence ) {
+						append_row( true );
+						if ( ! sequence_rows.empty() && sequence_rows.front().address != 0 ) {
+							rows.insert( rows.end(), sequence_rows.begin(), sequence_rows.end() );
+						}
+						sequence_rows.clear();
+						address = 0;
+						file    = 1;
+						line    = 1;
+					}
+					else if ( extended_code == DW_LNE_set_address ) {
+						address = extended.read_unsigned( address_size );
+					}
+				}
+				else {
+					switch ( opcode ) {
+						case DW_LNS_copy             : { append_row( false );                                   break; }
+						case DW_LNS_advance_pc       : { advance_address( program.read_uleb128() );             break; }
+						case DW_LNS_advance_line     : { line += program.read_sleb128();                        break; }
+						case DW_LNS_set_file         : { file  = program.read_uleb128();                        break; }
+						case DW_LNS_const_add_pc     : { advance_address( ( 255u - opcode_base ) / line_range ); break; }
+						case DW_LNS_fixed_advance_pc : { address += program.read<uint16_t>();                   break; }
+						default : {
+							// Skip the ULEB128 arguments of any other standard opcode
+							for (size_t arg_ctr = 0; arg_ctr < standard_opcode_lengths[ opcode - 1u ]; ++arg_ctr) {
+								program.read_uleb128();
+							}
+						}
+					}
+				}
+			}
+		}
+
+	public:
+		dwarf_line_table() = default;
+
+		/// \brief Ctor from the .debug_line, .debug_str and .debug_line_str sections (any of which may be empty)
+		dwarf_line_table(byte_reader prm_debug_line,    ///< The .debug_line section
+		                 byte_reader prm_debug_str,     ///< The .debug_str section
+		                 byte_reader prm_debug_line_str ///< The .debug_line_str section
+		                 ) {
+			const string_sections sections{ prm_debug_str, prm_debug_line_str };
+			::std::unordered_map<::std::string, uint32_t> file_lookup;
+			while ( ! prm_debug_line.at_end() ) {
+				uint64_t   unit_length = prm_debug_line.read<uint32_t>();
+				const bool is_64       = ( unit_length == 0xFFFFFFFFu );
+				if ( is_64 ) {
+					unit_length = prm_debug_line.read<uint64_t>();
+				}
+				byte_reader unit = prm_debug_line.sub_reader( static_cast<size_t>( unit_length ) );
+				if ( ! prm_debug_line.ok() ) {
+					break;
+				}
+				parse_unit( unit, is_64, sections, file_lookup );
+			}
+
+			// Sort by address, putting end-of-sequence rows before any row that starts at the same address
+			::std::stable_sort(
+				rows.begin(),
+				rows.end(),
+				[] (const row &x, const row &y) {
+					return ( x.address != y.address )
+						? ( x.address < y.address )
+						: ( x.file_index == end_sequence_file && y.file_index != end_sequence_file );
+				}
+			);
+			rows.shrink_to_fit();
+		}
+
+		/// \brief Look up the file and line for the specified module-relative address
+		///
+		/// \returns A pointer to the file path and the line, or (nullptr, 0) if not found
+		::std::pair<const ::std::string *, size_t> lookup(const uint64_t &prm_address ///< The module-relative address to look up
+		                                                  ) const {
+			const auto row_itr = ::std::upper_bound(
+				rows.begin(),
+				rows.end(),
+				prm_address,
+				[] (const uint64_t &x, const row &y) { return x < y.address; }
+			);
+			if ( row_itr == rows.begin() ) {
+				return { nullptr, 0 };
+			}
+			const row &the_row = *::std::prev( row_itr );
+			if ( the_row.file_index == end_sequence_file || the_row.file_index >= files.size() ) {
+				return { nullptr, 0 };
+			}
+			return { &files[ the_row.file_index ], the_row.line };
+		}
+
+		/// \brief Whether there are no rows
+		bool empty() const {
+			return rows.empty();
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_DWARF_LINE_TABLE_HPP
@@ -0,0 +1,111 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_ELF_BUILD_ID_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_ELF_BUILD_ID_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <elf.h>
+#include <link.h>
+
+#include "tell/detail/byte_reader.hpp"
+#include "tell/detail/mapped_file.hpp"
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief Find the GNU build-id (the raw bytes of the NT_GNU_BUILD_ID note's descriptor) in the specified ELF notes
+	///
+	/// \returns The build-id, or an empty string if there isn't one
+	inline ::std::string find_gnu_build_id(byte_reader prm_notes ///< A reader of the contents of a PT_NOTE segment or SHT_NOTE section
+	                                       ) {
+		constexpr size_t note_alignment = 4;
+		const auto aligned = [] (const size_t &x) { return ( x + note_alignment - 1 ) & ~( note_alignment - 1 ); };
+		while ( prm_notes.remaining() >= sizeof( ElfW(Nhdr) ) ) {
+			const auto   note_header = prm_notes.read<ElfW(Nhdr)>();
+			byte_reader  name        = prm_notes.sub_reader( note_header.n_namesz );
+			prm_notes.skip( aligned( note_header.n_namesz ) - note_header.n_namesz );
+			byte_reader  descriptor  = prm_notes.sub_reader( note_header.n_descsz );
+			prm_notes.skip( aligned( note_header.n_descsz ) - note_header.n_descsz );
+			if ( ! prm_notes.ok() ) {
+				break;
+			}
+			if ( note_header.n_type == NT_GNU_BUILD_ID
+					&& note_header.n_namesz == sizeof( ELF_NOTE_GNU )
+					&& ::std::memcmp( name.position(), ELF_NOTE_GNU, sizeof( ELF_NOTE_GNU ) ) == 0 ) {
+				return { reinterpret_cast<const char *>( descriptor.position() ), descriptor.remaining() };
+			}
+		}
+		return {};
+	}
+
+	/// \brief Find the GNU build-id of the module that dl_iterate_phdr() has described with the specified info, from its loaded PT_NOTE segments
+	///
+	/// This reads the module's notes from memory so it doesn't touch the file
+	///
+	/// \returns The build-id, or an empty string if there isn't one
+	inline ::std::string find_gnu_build_id_of_loaded_module(const ::dl_phdr_info &prm_info ///< The information about the module
+	                                                        ) {
+		for (size_t header_ctr = 0; header_ctr < prm_info.dlpi_phnum; ++header_ctr) {
+			const auto &program_header = prm_info.dlpi_phdr[ header_ctr ];
+			if ( program_header.p_type == PT_NOTE ) {
+				const auto notes_ptr = reinterpret_cast<const unsigned char *>( prm_info.dlpi_addr + program_header.p_vaddr );
+				auto       build_id  = find_gnu_build_id( byte_reader{ notes_ptr, static_cast<size_t>( program_header.p_memsz ) } );
+				if ( ! build_id.empty() ) {
+					return build_id;
+				}
+			}
+		}
+		return {};
+	}
+
+	/// \brief Find the GNU build-id of the specified mapped ELF file, from its PT_NOTE segments
+	///
+	/// \returns The build-id, or an empty string if there isn't one (or the file isn't ELF of the current process's class)
+	inline ::std::string find_gnu_build_id_of_elf_file(const mapped_file &prm_file ///< The mapped ELF file
+	                                                   ) {
+		byte_reader reader{ prm_file.data(), prm_file.size() };
+		const auto elf_header = reader.read<ElfW(Ehdr)>();
+		if ( ! reader.ok()
+				|| ::std::memcmp( elf_header.e_ident, ELFMAG, SELFMAG ) != 0
+				|| elf_header.e_ident[ EI_CLASS ] != ( sizeof( void * ) == 8 ? ELFCLASS64 : ELFCLASS32 )
+				|| elf_header.e_phentsize != sizeof( ElfW(Phdr) )
+				|| elf_header.e_phoff > prm_file.size() ) {
+			return {};
+		}
+		byte_reader program_headers_reader{ prm_file.data() + elf_header.e_phoff, prm_file.size() - elf_header.e_phoff };
+		for (size_t header_ctr = 0; header_ctr < elf_header.e_phnum; ++header_ctr) {
+			const auto program_header = program_headers_reader.read<ElfW(Phdr)>();
+			if ( ! program_headers_reader.ok() ) {
+				break;
+			}
+			if ( program_header.p_type == PT_NOTE
+					&& program_header.p_offset <= prm_file.size()
+					&& program_header.p_filesz <= prm_file.size() - program_header.p_offset ) {
+				auto build_id = find_gnu_build_id( byte_reader{ prm_file.data() + program_header.p_offset, static_cast<size_t>( program_header.p_filesz ) } );
+				if ( ! build_id.empty() ) {
+					return build_id;
+				}
+			}
+		}
+		return {};
+	}
+
+	/// \brief Generate the conventional lower-case hex string for the specified (raw) build-id
+	inline ::std::string build_id_to_hex(const ::std::string &prm_build_id ///< The raw build-id
+	                                     ) {
+		::std::string result;
+		result.reserve( 2 * prm_build_id.size() );
+		for (const char &the_char : prm_build_id) {
+			const auto the_byte = static_cast<unsigned char>( the_char );
+			result += "0123456789abcdef"[ the_byte >> 4   ];
+			result += "0123456789abcdef"[ the_byte & 0xFu ];
+		}
+		return result;
+	}
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_ELF_BUILD_ID_HPP
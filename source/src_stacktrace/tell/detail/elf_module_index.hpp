@@ -0,0 +1,183 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_ELF_MODULE_INDEX_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_ELF_MODULE_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <elf.h>
+#include <link.h>
+
+#include <boost/core/demangle.hpp>
+
+#include "tell/detail/byte_reader.hpp"
+#include "tell/detail/dwarf_line_table.hpp"
+#include "tell/detail/mapped_file.hpp"
+#include "tell/symbol_info.hpp"
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief An index of the function symbols and DWARF line table of one ELF file, which is mmap'd
+	///
+	/// Lookups are by module-relative address (ie the address in the ELF file's own virtual address
+	/// space, which is the run-time address minus the module's load bias). The symbols are sorted
+	/// by address at construction so that each lookup is a binary search.
+	///
+	/// Only ELF files of the same class (32/64-bit) and byte order as the current process are supported.
+	/// Compressed debug sections and separate debug files are not supported, in which case the
+	/// index will just have the symbols.
+	class elf_module_index final {
+	private:
+		/// \brief A function symbol
+		struct symbol final {
+			/// \brief The module-relative address of the start of the symbol
+			uint64_t     address;
+
+			/// \brief The size of the symbol in bytes (which may be 0 if unknown)
+			uint64_t     size;
+
+			/// \brief The (mangled) name of the symbol, pointing into the mapped file
+			const char * name;
+		};
+
+		/// \brief The mapped file
+		mapped_file file;
+
+		/// \brief The function symbols, sorted by address
+		::std::vector<symbol> symbols;
+
+		/// \brief The index of the DWARF line table
+		dwarf_line_table line_table;
+
+		/// \brief Make a byte_reader for the specified section header's contents, or an empty one if it's not readable
+		byte_reader section_reader(const ElfW(Shdr) &prm_section_header ///< The section's header
+		                           ) const {
+			if ( prm_section_header.sh_type == SHT_NOBITS
+					|| ( prm_section_header.sh_flags & SHF_COMPRESSED ) != 0
+					|| prm_section_header.sh_offset > file.size()
+					|| prm_section_header.sh_size   > file.size() - prm_section_header.sh_offset ) {
+				return {};
+			}
+			return { file.data() + prm_section_header.sh_offset, static_cast<size_t>( prm_section_header.sh_size ) };
+		}
+
+		/// \brief Add the function symbols from the specified symbol table section
+		void add_symbols(const ElfW(Shdr) &prm_symtab_header, ///< The header of the symbol table section
+		                 const ElfW(Shdr) &prm_strtab_header  ///< The header of the associated string table section
+		                 ) {
+			byte_reader       symtab = section_reader( prm_symtab_header );
+			const byte_reader strtab = section_reader( prm_strtab_header );
+			while ( symtab.remaining() >= sizeof( ElfW(Sym) ) ) {
+				const auto sym  = symtab.read<ElfW(Sym)>();
+				const auto type = ELF64_ST_TYPE( sym.st_info );
+				if ( ( type != STT_FUNC && type != STT_GNU_IFUNC ) || sym.st_shndx == SHN_UNDEF || sym.st_value == 0 || sym.st_name >= strtab.remaining() ) {
+					continue;
+				}
+				const auto name = reinterpret_cast<const char *>( strtab.position() + sym.st_name );
+				if ( ::memchr( name, '\0', strtab.remaining() - sym.st_name ) != nullptr ) {
+					symbols.push_back( { sym.st_value, sym.st_size, name } );
+				}
+			}
+		}
+
+	public:
+		/// \brief Ctor from the path of the ELF file to index
+		explicit elf_module_index(const ::std::string &prm_path ///< The path of the ELF file
+		                          ) : file{ prm_path } {
+			byte_reader reader{ file.data(), file.size() };
+			const auto elf_header = reader.read<ElfW(Ehdr)>();
+			if ( ! reader.ok()
+					|| ::std::memcmp( elf_header.e_ident, ELFMAG, SELFMAG ) != 0
+					|| elf_header.e_ident[ EI_CLASS ] != ( sizeof( void * ) == 8 ? ELFCLASS64 : ELFCLASS32 )
+					|| elf_header.e_shentsize != sizeof( ElfW(Shdr) )
+					|| elf_header.e_shoff > file.size() ) {
+				return;
+			}
+
+			// Read the section headers and the section-name string table
+			byte_reader section_headers_reader{ file.data() + elf_header.e_shoff, file.size() - elf_header.e_shoff };
+			::std::vector<ElfW(Shdr)> section_headers;
+			for (size_t section_ctr = 0; section_ctr < elf_header.e_shnum && section_headers_reader.ok(); ++section_ctr) {
+				section_headers.push_back( section_headers_reader.read<ElfW(Shdr)>() );
+			}
+			if ( ! section_headers_reader.ok() || elf_header.e_shstrndx >= section_headers.size() ) {
+				return;
+			}
+			const byte_reader section_names = section_reader( section_headers[ elf_header.e_shstrndx ] );
+			const auto section_name = [&] (const ElfW(Shdr) &x) -> const char * {
+				byte_reader name_reader = section_names;
+				name_reader.skip( x.sh_name );
+				return name_reader.read_cstring();
+			};
+
+			// Gather the function symbols, preferring the full .symtab over .dynsym (which only has the exported symbols)
+			const auto add_symbols_of_type = [&] (const uint32_t &prm_type) {
+				for (const auto &section_header : section_headers) {
+					if ( section_header.sh_type == prm_type && section_header.sh_link < section_headers.size() ) {
+						add_symbols( section_header, section_headers[ section_header.sh_link ] );
+					}
+				}
+			};
+			add_symbols_of_type( SHT_SYMTAB );
+			if ( symbols.empty() ) {
+				add_symbols_of_type( SHT_DYNSYM );
+			}
+			::std::sort(
+				symbols.begin(),
+				symbols.end(),
+				[] (const symbol &x, const symbol &y) { return x.address < y.address; }
+			);
+			symbols.shrink_to_fit();
+
+			// Build the line table from the DWARF sections
+			byte_reader debug_line, debug_str, debug_line_str;
+			for (const auto &section_header : section_headers) {
+				const char * const name = section_name( section_header );
+				if      ( ::std::strcmp( name, ".debug_line"     ) == 0 ) { debug_line     = section_reader( section_header ); }
+				else if ( ::std::strcmp( name, ".debug_str"      ) == 0 ) { debug_str      = section_reader( section_header ); }
+				else if ( ::std::strcmp( name, ".debug_line_str" ) == 0 ) { debug_line_str = section_reader( section_header ); }
+			}
+			line_table = dwarf_line_table{ debug_line, debug_str, debug_line_str };
+		}
+
+		/// \brief Look up the function, file and line for the specified module-relative address
+		///
+		/// The module field of the result is left empty for the caller to populate
+		symbol_info lookup(const uint64_t &prm_address ///< The module-relative address to look up
+		                   ) const {
+			symbol_info result;
+
+			const auto symbol_itr = ::std::upper_bound(
+				symbols.begin(),
+				symbols.end(),
+				prm_address,
+				[] (const uint64_t &x, const symbol &y) { return x < y.address; }
+			);
+			if ( symbol_itr != symbols.begin() ) {
+				const symbol &the_symbol = *::std::prev( symbol_itr );
+				if ( prm_address - the_symbol.address < the_symbol.size || prm_address == the_symbol.address ) {
+					result.function = ::boost::core::demangle( the_symbol.name );
+				}
+			}
+
+			const auto file_and_line = line_table.lookup( prm_address );
+			if ( file_and_line.first != nullptr ) {
+				result.file = *file_and_line.first;
+				result.line = file_and_line.second;
+			}
+			return result;
+		}
+
+		/// \brief Whether the file was mapped and parsed as ELF with either symbols or line information
+		bool empty() const {
+			return symbols.empty() && line_table.empty();
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_ELF_MODULE_INDEX_HPP
@@ -0,0 +1,390 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_LOADED_MODULE_MAP_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_LOADED_MODULE_MAP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <link.h>
+#include <unistd.h>
+
+#include "tell/detail/elf_build_id.hpp"
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief The identity and location of a module (executable or shared library) loaded into the process
+	struct loaded_module_info final {
+		/// \brief The difference between the module's run-time addresses and its ELF virtual addresses
+		uintptr_t                                        load_bias = 0;
+
+		/// \brief The run-time [begin, end) address ranges of the module's loaded segments
+		::std::vector<::std::pair<uintptr_t, uintptr_t>> segments;
+
+		/// \brief The path of the module's file (made absolute for the main program, where possible)
+		::std::string                                    path;
+
+		/// \brief The name to report for the module (which matches dladdr()'s dli_fname)
+		::std::string                                    name;
+
+		/// \brief The module's GNU build-id (raw bytes), or empty if it has none
+		::std::string                                    build_id;
+
+		/// \brief Whether the module is the main program (rather than a shared library)
+		bool                                             is_main_program = false;
+
+		/// \brief Whether the specified run-time address is within one of the module's loaded segments
+		bool contains(const uintptr_t &prm_address ///< The address to query
+		              ) const {
+			for (const auto &segment : segments) {
+				if ( prm_address >= segment.first && prm_address < segment.second ) {
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	/// \brief Type alias for a shared_ptr to a const loaded_module_info
+	using loaded_module_info_cptr = ::std::shared_ptr<const loaded_module_info>;
+
+	/// \brief An immutable snapshot of the modules loaded into the process, indexed for finding the module containing an address
+	class loaded_module_snapshot final {
+	private:
+		/// \brief A loaded segment: its run-time [begin, end) address range and the index of its module in modules
+		struct segment_entry final {
+			/// \brief The run-time address of the start of the segment
+			uintptr_t begin;
+
+			/// \brief The run-time address one past the end of the segment
+			uintptr_t end;
+
+			/// \brief The index of the segment's module in modules
+			size_t    module_index;
+		};
+
+		/// \brief The loaded modules
+		::std::vector<loaded_module_info_cptr> modules;
+
+		/// \brief The modules' segments, sorted by begin
+		::std::vector<segment_entry>           segments;
+
+		/// \brief The dynamic loader's count of modules loaded (dl_phdr_info::dlpi_adds) when this was taken
+		unsigned long long                     num_adds   = 0;
+
+		/// \brief The dynamic loader's count of modules unloaded (dl_phdr_info::dlpi_subs) when this was taken
+		unsigned long long                     num_subs   = 0;
+
+		/// \brief The number of snapshots taken before this one, used to tell whether a thread's cached snapshot is current
+		uint64_t                               generation = 0;
+
+		/// \brief Find the entry in modules for the module containing the specified address, or nullptr if there isn't one
+		const loaded_module_info_cptr * find_entry(const uintptr_t &prm_address ///< The address to query
+		                                           ) const {
+			// Find the last segment that begins at or before the address
+			const auto upper_itr = ::std::upper_bound(
+				segments.begin(),
+				segments.end(),
+				prm_address,
+				[] (const uintptr_t &x, const segment_entry &y) { return x < y.begin; }
+			);
+			if ( upper_itr == segments.begin() ) {
+				return nullptr;
+			}
+			const auto &the_segment = *::std::prev( upper_itr );
+			return ( prm_address < the_segment.end ) ? &modules[ the_segment.module_index ] : nullptr;
+		}
+
+	public:
+		/// \brief Default ctor, for an empty snapshot
+		loaded_module_snapshot() = default;
+
+		/// \brief Ctor from the modules and the loader's counters
+		loaded_module_snapshot(::std::vector<loaded_module_info_cptr>  prm_modules,   ///< The loaded modules
+		                       const unsigned long long               &prm_num_adds,  ///< The loader's count of modules loaded
+		                       const unsigned long long               &prm_num_subs,  ///< The loader's count of modules unloaded
+		                       const uint64_t                         &prm_generation ///< The number of snapshots taken before this one
+		                       ) : modules   { ::std::move( prm_modules ) },
+		                           num_adds  { prm_num_adds               },
+		                           num_subs  { prm_num_subs               },
+		                           generation{ prm_generation             } {
+			for (size_t module_ctr = 0; module_ctr < modules.size(); ++module_ctr) {
+				for (const auto &segment : modules[ module_ctr ]->segments) {
+					segments.push_back( segment_entry{ segment.first, segment.second, module_ctr } );
+				}
+			}
+			::std::sort(
+				segments.begin(),
+				segments.end(),
+				[] (const segment_entry &x, const segment_entry &y) { return x.begin < y.begin; }
+			);
+		}
+
+		/// \brief Find the module containing the specified address, or nullptr if there isn't one
+		///
+		/// The pointer remains valid for as long as this snapshot
+		const loaded_module_info * find(const uintptr_t &prm_address ///< The address to query
+		                                ) const {
+			const loaded_module_info_cptr * const module_ptr = find_entry( prm_address );
+			return ( module_ptr != nullptr ) ? module_ptr->get() : nullptr;
+		}
+
+		/// \brief Find the module containing the specified address, or nullptr if there isn't one, sharing ownership of it
+		loaded_module_info_cptr find_shared(const uintptr_t &prm_address ///< The address to query
+		                                    ) const {
+			const loaded_module_info_cptr * const module_ptr = find_entry( prm_address );
+			return ( module_ptr != nullptr ) ? *module_ptr : nullptr;
+		}
+
+		/// \brief Get the loaded modules
+		const ::std::vector<loaded_module_info_cptr> & get_modules() const noexcept {
+			return modules;
+		}
+
+		/// \brief Get the dynamic loader's count of modules loaded when this was taken
+		const unsigned long long & get_num_adds() const noexcept {
+			return num_adds;
+		}
+
+		/// \brief Get the dynamic loader's count of modules unloaded when this was taken
+		const unsigned long long & get_num_subs() const noexcept {
+			return num_subs;
+		}
+
+		/// \brief Get the number of snapshots taken before this one
+		const uint64_t & get_generation() const noexcept {
+			return generation;
+		}
+	};
+
+	/// \brief Type alias for a shared_ptr to a const loaded_module_snapshot
+	using loaded_module_snapshot_cptr = ::std::shared_ptr<const loaded_module_snapshot>;
+
+	/// \brief A map from run-time addresses to the loaded modules that contain them, with each module's build-id
+	///
+	/// Lookups read an immutable loaded_module_snapshot without taking any lock (or calling into the
+	/// dynamic loader, whose dl_iterate_phdr() and dladdr() serialize on the loader's global lock). Each
+	/// thread keeps its own reference to the current snapshot and only re-fetches it (under a brief lock)
+	/// when the (rarely changing) generation counter says a newer one has been published. find() returns
+	/// a plain pointer into the thread's snapshot, so concurrent find()s write no shared memory at all
+	/// (not even a reference count); find_shared() is for callers that need to keep a module for longer.
+	///
+	/// A new snapshot is only taken when a lookup misses every known module and the dynamic loader's
+	/// dlpi_adds/dlpi_subs counters show that a module has been loaded or unloaded (ie on dlopen()/dlclose())
+	/// since the current snapshot was taken. Modules that are still loaded keep the same loaded_module_info
+	/// across snapshots, so users can key per-module data (like elf_symbolizer's indices) on them. A module
+	/// that's dlclose()d remains in the snapshot until the next miss, so a program that maps new code over
+	/// an unloaded module's addresses should call refresh() after the dlopen().
+	///
+	/// The build-ids are read from the modules' loaded PT_NOTE segments (so no files are read).
+	///
+	/// Use instance() to get the process-wide map.
+	class loaded_module_map final {
+	private:
+		/// \brief The state of a scan of the loaded modules by dl_iterate_phdr()
+		struct module_scan final {
+			/// \brief The snapshot to compare with, to skip the scan if no modules have been loaded or unloaded since
+			const loaded_module_snapshot           &previous;
+
+			/// \brief Whether the loader's counters matched previous's (in which case the scan was stopped)
+			bool                                    unchanged = false;
+
+			/// \brief The loader's count of modules loaded
+			unsigned long long                      num_adds  = 0;
+
+			/// \brief The loader's count of modules unloaded
+			unsigned long long                      num_subs  = 0;
+
+			/// \brief The modules found
+			::std::vector<loaded_module_info_cptr>  modules;
+
+			/// \brief Ctor from the snapshot to compare with
+			explicit module_scan(const loaded_module_snapshot &prm_previous ///< The snapshot to compare with
+			                     ) : previous{ prm_previous } {
+			}
+		};
+
+		/// \brief Mutex to serialize the taking of new snapshots
+		::std::mutex                mutex;
+
+		/// \brief Mutex to protect latest
+		///
+		/// This is separate from mutex so that threads fetching the latest snapshot aren't blocked by a scan
+		mutable ::std::mutex        latest_mutex;
+
+		/// \brief The current snapshot
+		loaded_module_snapshot_cptr latest = ::std::make_shared<const loaded_module_snapshot>();
+
+		/// \brief The generation of latest, which threads check to see whether their cached snapshot is still current
+		::std::atomic<uint64_t>     latest_generation{ 0 };
+
+		/// \brief Private default ctor so that the only loaded_module_map is the one from instance()
+		///        (which the thread-local caching of snapshots relies on)
+		loaded_module_map() = default;
+
+		/// \brief Get the latest snapshot
+		loaded_module_snapshot_cptr get_latest() const {
+			const ::std::lock_guard<::std::mutex> lock{ latest_mutex };
+			return latest;
+		}
+
+		/// \brief Get the calling thread's cached snapshot (which may be null or out of date)
+		static loaded_module_snapshot_cptr & thread_snapshot() {
+			static thread_local loaded_module_snapshot_cptr cached_snapshot;
+			return cached_snapshot;
+		}
+
+		/// \brief Get the path of the main program's file, or an empty string if it can't be determined
+		static ::std::string main_program_path() {
+			char         buffer[ 4096 ];
+			const auto   num_chars = ::readlink( "/proc/self/exe", buffer, sizeof( buffer ) );
+			return ( num_chars > 0 ) ? ::std::string{ buffer, static_cast<size_t>( num_chars ) } : ::std::string{};
+		}
+
+		/// \brief Callback for dl_iterate_phdr() to record each module
+		///
+		/// This stops the scan at the first module if the loader's counters show nothing has changed since the previous snapshot
+		static int record_module(::dl_phdr_info * prm_info, ///< The information about the module
+		                         size_t           prm_size, ///< The size of the dl_phdr_info (which shows whether it has the counters)
+		                         void           * prm_data  ///< The module_scan to which the module should be added
+		                         ) {
+			auto &the_scan = *static_cast<module_scan *>( prm_data );
+			if ( the_scan.modules.empty() && prm_size >= offsetof( ::dl_phdr_info, dlpi_subs ) + sizeof( prm_info->dlpi_subs ) ) {
+				the_scan.num_adds = prm_info->dlpi_adds;
+				the_scan.num_subs = prm_info->dlpi_subs;
+				if ( the_scan.num_adds == the_scan.previous.get_num_adds() && the_scan.num_subs == the_scan.previous.get_num_subs() ) {
+					the_scan.unchanged = true;
+					return 1;
+				}
+			}
+			const bool is_main_program = ( prm_info->dlpi_name == nullptr || prm_info->dlpi_name[ 0 ] == '\0' );
+			const auto load_bias       = static_cast<uintptr_t>( prm_info->dlpi_addr );
+
+			// Keep the previous snapshot's loaded_module_info for a module that's still loaded
+			for (const auto &previous_module : the_scan.previous.get_modules()) {
+				if ( previous_module->load_bias == load_bias && previous_module->is_main_program == is_main_program
+						&& ( is_main_program || previous_module->path == prm_info->dlpi_name ) ) {
+					the_scan.modules.push_back( previous_module );
+					return 0;
+				}
+			}
+
+			auto the_module = ::std::make_shared<loaded_module_info>();
+			the_module->load_bias       = load_bias;
+			the_module->path            = is_main_program ? main_program_path()     : prm_info->dlpi_name;
+			the_module->name            = is_main_program ? program_invocation_name : prm_info->dlpi_name;
+			the_module->build_id        = find_gnu_build_id_of_loaded_module( *prm_info );
+			the_module->is_main_program = is_main_program;
+			for (size_t header_ctr = 0; header_ctr < prm_info->dlpi_phnum; ++header_ctr) {
+				const auto &program_header = prm_info->dlpi_phdr[ header_ctr ];
+				if ( program_header.p_type == PT_LOAD ) {
+					const auto begin = static_cast<uintptr_t>( prm_info->dlpi_addr + program_header.p_vaddr );
+					the_module->segments.emplace_back( begin, begin + program_header.p_memsz );
+				}
+			}
+			the_scan.modules.push_back( ::std::move( the_module ) );
+			return 0;
+		}
+
+		/// \brief Take and publish a new snapshot if any modules have been loaded or unloaded since the latest one
+		///
+		/// The mutex must be held by the caller
+		///
+		/// \returns The latest snapshot (which is the new one if one was taken)
+		loaded_module_snapshot_cptr refresh_locked() {
+			const auto  previous = get_latest();
+			module_scan the_scan{ *previous };
+			::dl_iterate_phdr( &record_module, &the_scan );
+			if ( the_scan.unchanged ) {
+				return previous;
+			}
+
+			const uint64_t generation = previous->get_generation() + 1;
+			auto new_snapshot = ::std::make_shared<const loaded_module_snapshot>(
+				::std::move( the_scan.modules ),
+				the_scan.num_adds,
+				the_scan.num_subs,
+				generation
+			);
+			{
+				const ::std::lock_guard<::std::mutex> lock{ latest_mutex };
+				latest = new_snapshot;
+			}
+			latest_generation.store( generation, ::std::memory_order_release );
+			return new_snapshot;
+		}
+
+	public:
+		/// \brief Get the current snapshot of the loaded modules (which only takes a lock if a new snapshot has been taken since the calling thread's last call)
+		///
+		/// The reference is to the calling thread's cached snapshot so remains valid until
+		/// the thread next calls snapshot() (or find()); copy it to keep it for longer.
+		const loaded_module_snapshot_cptr & snapshot() {
+			auto &cached_snapshot = thread_snapshot();
+			if ( ! cached_snapshot || cached_snapshot->get_generation() != latest_generation.load( ::std::memory_order_acquire ) ) {
+				cached_snapshot = get_latest();
+			}
+			return cached_snapshot;
+		}
+
+		/// \brief Get the generation of the current snapshot, which changes whenever a new snapshot is taken
+		///
+		/// This doesn't lock, so callers can cheaply check whether data derived from an earlier snapshot may be out of date
+		uint64_t get_generation() const noexcept {
+			return latest_generation.load( ::std::memory_order_acquire );
+		}
+
+		/// \brief Find the loaded module containing the specified address, or nullptr if there isn't one
+		///
+		/// This only takes a lock (and calls dl_iterate_phdr()) if the address isn't in any of the known modules.
+		///
+		/// The pointer is into the calling thread's cached snapshot so remains valid until the thread next calls
+		/// find() (or snapshot()); use find_shared() (or copy snapshot()) to keep the module for longer.
+		const loaded_module_info * find(const uintptr_t &prm_address ///< The address to query
+		                                ) {
+			if ( const auto * const the_module = snapshot()->find( prm_address ) ) {
+				return the_module;
+			}
+
+			const ::std::lock_guard<::std::mutex> lock{ mutex };
+			// Another thread may have taken a new snapshot while this one was waiting for the lock
+			auto &cached_snapshot = thread_snapshot();
+			cached_snapshot = get_latest();
+			if ( const auto * const the_module = cached_snapshot->find( prm_address ) ) {
+				return the_module;
+			}
+			cached_snapshot = refresh_locked();
+			return cached_snapshot->find( prm_address );
+		}
+
+		/// \brief Find the loaded module containing the specified address, or nullptr if there isn't one, sharing ownership of it
+		loaded_module_info_cptr find_shared(const uintptr_t &prm_address ///< The address to query
+		                                    ) {
+			// If find() finds the module, it leaves it in the thread's cached snapshot
+			return ( find( prm_address ) != nullptr ) ? thread_snapshot()->find_shared( prm_address ) : nullptr;
+		}
+
+		/// \brief Take a new snapshot now if any modules have been loaded or unloaded since the latest one
+		void refresh() {
+			const ::std::lock_guard<::std::mutex> lock{ mutex };
+			refresh_locked();
+		}
+
+		/// \brief Get the process-wide loaded_module_map
+		static loaded_module_map & instance() {
+			static loaded_module_map the_instance;
+			return the_instance;
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_LOADED_MODULE_MAP_HPP
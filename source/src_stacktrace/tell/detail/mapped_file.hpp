@@ -0,0 +1,92 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_MAPPED_FILE_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief A read-only memory mapping of a whole file
+	///
+	/// If the file can't be opened or mapped, the result is empty rather than an error:
+	/// this is used whilst describing an error so it shouldn't throw another.
+	class mapped_file final {
+	private:
+		/// \brief The start of the mapping, or nullptr if empty
+		void * data_ptr = nullptr;
+
+		/// \brief The size of the mapping in bytes
+		size_t num_bytes = 0;
+
+	public:
+		mapped_file() noexcept = default;
+
+		/// \brief Ctor from the path of the file to map
+		explicit mapped_file(const ::std::string &prm_path ///< The path of the file to map
+		                     ) noexcept {
+			const int fd = ::open( prm_path.c_str(), O_RDONLY | O_CLOEXEC );
+			if ( fd < 0 ) {
+				return;
+			}
+			struct ::stat file_stat{};
+			if ( ::fstat( fd, &file_stat ) == 0 && file_stat.st_size > 0 ) {
+				const auto size = static_cast<size_t>( file_stat.st_size );
+				void * const ptr = ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+				if ( ptr != MAP_FAILED ) {
+					data_ptr  = ptr;
+					num_bytes = size;
+				}
+			}
+			::close( fd );
+		}
+
+		~mapped_file() noexcept {
+			if ( data_ptr != nullptr ) {
+				::munmap( data_ptr, num_bytes );
+			}
+		}
+
+		mapped_file(const mapped_file &) = delete;
+		mapped_file & operator=(const mapped_file &) = delete;
+
+		/// \brief Move ctor
+		mapped_file(mapped_file &&prm_other ///< The mapped_file from which to take the mapping
+		            ) noexcept : data_ptr { ::std::exchange( prm_other.data_ptr,  nullptr ) },
+		                         num_bytes{ ::std::exchange( prm_other.num_bytes, 0       ) } {
+		}
+
+		/// \brief Move assignment operator
+		mapped_file & operator=(mapped_file &&prm_other ///< The mapped_file from which to take the mapping
+		                        ) noexcept {
+			::std::swap( data_ptr,  prm_other.data_ptr  );
+			::std::swap( num_bytes, prm_other.num_bytes );
+			return *this;
+		}
+
+		/// \brief The start of the mapped bytes, or nullptr if empty
+		const unsigned char * data() const noexcept {
+			return static_cast<const unsigned char *>( data_ptr );
+		}
+
+		/// \brief The number of mapped bytes
+		size_t size() const noexcept {
+			return num_bytes;
+		}
+
+		/// \brief Whether nothing is mapped
+		bool empty() const noexcept {
+			return ( data_ptr == nullptr );
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_MAPPED_FILE_HPP
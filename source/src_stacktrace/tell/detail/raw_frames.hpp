@@ -0,0 +1,121 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_RAW_FRAMES_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_RAW_FRAMES_HPP
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+
+#include <boost/stacktrace.hpp>
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief Type alias for the type Boost Stacktrace uses to store a raw frame address
+	using native_frame_ptr_t = ::boost::stacktrace::frame::native_frame_ptr_t;
+
+	/// \brief Get the address of the specified Boost Stacktrace frame
+	inline const void * frame_address(const ::boost::stacktrace::frame &prm_frame ///< The frame to query
+	                                  ) {
+		return prm_frame.address();
+	}
+
+	/// \brief Get the address of the specified raw frame
+	inline const void * frame_address(const native_frame_ptr_t &prm_frame ///< The frame to query
+	                                  ) {
+		return prm_frame;
+	}
+
+	/// \brief A fixed-capacity, inline store of raw frame return addresses
+	///
+	/// Capturing into this doesn't allocate: the addresses are written straight into the inline
+	/// buffer via boost::stacktrace::safe_dump_to(). The (comparatively expensive) conversion to
+	/// a boost::stacktrace::stacktrace is deferred until to_stacktrace() is called, which
+	/// should only happen when the frames actually need rendering.
+	///
+	/// At most Capacity frames are kept; if the stack is deeper than that (or than the maximum depth
+	/// requested), the frames beyond are dropped and the raw_frames is marked as truncated.
+	template <size_t Capacity>
+	class raw_frames final {
+	private:
+		/// \brief The raw frame addresses, with room for one more frame than is kept (to detect truncation)
+		///        and for the terminating null that safe_dump_to() writes
+		::std::array<native_frame_ptr_t, Capacity + 2> addresses{};
+
+		/// \brief The number of valid frames in addresses
+		size_t num_frames = 0;
+
+		/// \brief Whether the stack had more frames than were kept
+		bool truncated = false;
+
+	public:
+		/// \brief Type alias for the const_iterator type
+		using const_iterator = typename ::std::array<native_frame_ptr_t, Capacity + 2>::const_iterator;
+
+		/// \brief Capture the current call stack, with the function that calls this as the first frame
+		///
+		/// The unwinding stops after one frame more than will be kept (which is just used to detect truncation),
+		/// so the cost is bounded by the maximum depth rather than by the depth of the stack.
+		///
+		/// This is forced inline so that, like boost::stacktrace::stacktrace(), the first frame is the caller
+		BOOST_FORCEINLINE static raw_frames capture(const size_t &prm_skip,                ///< The number of (innermost) frames to skip
+		                                            const size_t &prm_max_depth = Capacity ///< The maximum number of frames to keep after skipping (capped at Capacity)
+		                                            ) noexcept {
+			raw_frames   result;
+			const size_t max_depth  = ( prm_max_depth < Capacity ) ? prm_max_depth : Capacity;
+			const size_t num_dumped = ::boost::stacktrace::safe_dump_to(
+				prm_skip,
+				result.addresses.data(),
+				( max_depth + 2 ) * sizeof( native_frame_ptr_t )
+			);
+			// safe_dump_to() returns the number of frames *including* the terminating null one
+			result.num_frames = ( num_dumped > 0 ) ? ( num_dumped - 1 ) : 0;
+			if ( result.num_frames > max_depth ) {
+				result.num_frames                     = max_depth;
+				result.truncated                      = true;
+				result.addresses[ result.num_frames ] = nullptr;
+			}
+			return result;
+		}
+
+		/// \brief The number of frames stored
+		size_t size() const noexcept {
+			return num_frames;
+		}
+
+		/// \brief Whether the stack had more frames than were kept
+		bool is_truncated() const noexcept {
+			return truncated;
+		}
+
+		/// \brief Whether no frames are stored
+		bool empty() const noexcept {
+			return ( num_frames == 0 );
+		}
+
+		/// \brief Standard const begin() operator
+		const_iterator begin() const noexcept {
+			return addresses.begin();
+		}
+
+		/// \brief Standard const end() operator
+		const_iterator end() const noexcept {
+			return ::std::next( addresses.begin(), static_cast<ptrdiff_t>( num_frames ) );
+		}
+
+		/// \brief Make a boost::stacktrace::stacktrace of the stored frames
+		///
+		/// This allocates, so should only be called when the frames are to be rendered
+		::boost::stacktrace::stacktrace to_stacktrace() const {
+			// Include the terminating null frame in the size: from_dump() stops at it and
+			// mishandles a buffer holding exactly one frame
+			return ::boost::stacktrace::stacktrace::from_dump(
+				addresses.data(),
+				( num_frames + 1 ) * sizeof( native_frame_ptr_t )
+			);
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_RAW_FRAMES_HPP
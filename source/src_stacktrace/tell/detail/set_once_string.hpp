@@ -0,0 +1,82 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_SET_ONCE_STRING_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_SET_ONCE_STRING_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief A string slot that starts empty and can be set (at most) once, safely from concurrent threads
+	///
+	/// This is for memoizing text derived from an immutable object in that object. Reads are a single
+	/// acquire load; if several threads set it concurrently, the first wins and the others get its value.
+	///
+	/// Copying doesn't copy the value (so a copy of the owning object re-derives its own) but moving does.
+	class set_once_string final {
+	private:
+		/// \brief The owned string, or nullptr if it hasn't been set
+		mutable ::std::atomic<const ::std::string *> value_ptr{ nullptr };
+
+	public:
+		/// \brief Default ctor, for an unset slot
+		set_once_string() noexcept = default;
+
+		/// \brief Copy ctor, which makes an unset slot
+		set_once_string(const set_once_string &/* prm_other */
+		                ) noexcept {
+		}
+
+		/// \brief Move ctor, which takes the other's value
+		set_once_string(set_once_string &&prm_other ///< The set_once_string from which to take the value
+		                ) noexcept : value_ptr{ prm_other.value_ptr.exchange( nullptr ) } {
+		}
+
+		/// \brief Copy assignment operator, which unsets this slot
+		set_once_string & operator=(const set_once_string &prm_other ///< The set_once_string being copied
+		                            ) noexcept {
+			if ( &prm_other != this ) {
+				delete value_ptr.exchange( nullptr );
+			}
+			return *this;
+		}
+
+		/// \brief Move assignment operator, which takes the other's value
+		set_once_string & operator=(set_once_string &&prm_other ///< The set_once_string from which to take the value
+		                            ) noexcept {
+			if ( &prm_other != this ) {
+				delete value_ptr.exchange( prm_other.value_ptr.exchange( nullptr ) );
+			}
+			return *this;
+		}
+
+		/// \brief Dtor, which frees the value
+		~set_once_string() noexcept {
+			delete value_ptr.load();
+		}
+
+		/// \brief Get the value, or nullptr if it hasn't been set
+		const ::std::string * get() const noexcept {
+			return value_ptr.load( ::std::memory_order_acquire );
+		}
+
+		/// \brief Set the value to the specified string, unless it's already been set
+		///
+		/// \returns The value (which is the one set by another thread if that thread got there first)
+		const ::std::string & set(::std::string prm_value ///< The value to set
+		                          ) const {
+			auto                  new_value_ptr = ::std::make_unique<const ::std::string>( ::std::move( prm_value ) );
+			const ::std::string * expected      = nullptr;
+			if ( value_ptr.compare_exchange_strong( expected, new_value_ptr.get(), ::std::memory_order_acq_rel, ::std::memory_order_acquire ) ) {
+				return *new_value_ptr.release();
+			}
+			return *expected;
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_SET_ONCE_STRING_HPP
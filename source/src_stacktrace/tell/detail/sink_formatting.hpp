@@ -0,0 +1,83 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_SINK_FORMATTING_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_SINK_FORMATTING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief Write the specified null-terminated string (or "(null)" for nullptr) to the specified sink
+	///
+	/// A sink is anything with a write(const char *, const size_t &) member (see output_sinks.hpp)
+	template <typename Sink>
+	void write_cstring(Sink               &prm_sink,  ///< The sink to which the string should be written
+	                   const char * const  prm_string ///< The string to write
+	                   ) {
+		const char * const string = ( prm_string != nullptr ) ? prm_string : "(null)";
+		prm_sink.write( string, ::std::strlen( string ) );
+	}
+
+	/// \brief Write the specified string to the specified sink
+	template <typename Sink>
+	void write_string(Sink                &prm_sink,  ///< The sink to which the string should be written
+	                  const ::std::string &prm_string ///< The string to write
+	                  ) {
+		prm_sink.write( prm_string.data(), prm_string.size() );
+	}
+
+	/// \brief Write the specified integer in decimal to the specified sink, right-aligned in a field of (at least) the specified width
+	template <typename Sink>
+	void write_decimal(Sink          &prm_sink,     ///< The sink to which the value should be written
+	                   const int64_t &prm_value,    ///< The value to write
+	                   const size_t  &prm_width = 0 ///< The minimum width of the field
+	                   ) {
+		char     digits[ 24 ];
+		size_t   num_digits = 0;
+		uint64_t magnitude  = ( prm_value < 0 ) ? ( 0 - static_cast<uint64_t>( prm_value ) ) : static_cast<uint64_t>( prm_value );
+		do {
+			digits[ sizeof( digits ) - ++num_digits ] = static_cast<char>( '0' + ( magnitude % 10 ) );
+			magnitude /= 10;
+		} while ( magnitude != 0 );
+		if ( prm_value < 0 ) {
+			digits[ sizeof( digits ) - ++num_digits ] = '-';
+		}
+		for (size_t pad_ctr = num_digits; pad_ctr < prm_width; ++pad_ctr) {
+			prm_sink.write( " ", 1 );
+		}
+		prm_sink.write( digits + sizeof( digits ) - num_digits, num_digits );
+	}
+
+	/// \brief Write the specified value to the specified sink as "0x" followed by 16 upper-case hex digits (matching Boost Stacktrace)
+	template <typename Sink>
+	void write_hex(Sink           &prm_sink, ///< The sink to which the value should be written
+	               const uint64_t &prm_value ///< The value to write
+	               ) {
+		char digits[ 18 ] = { '0', 'x' };
+		for (size_t digit_ctr = 0; digit_ctr < 16; ++digit_ctr) {
+			digits[ 17 - digit_ctr ] = "0123456789ABCDEF"[ ( prm_value >> ( 4 * digit_ctr ) ) & 0xFu ];
+		}
+		prm_sink.write( digits, sizeof( digits ) );
+	}
+
+	/// \brief Write the specified value to the specified sink as unsigned LEB128 (as read by byte_reader::read_uleb128())
+	template <typename Sink>
+	void write_uleb128(Sink     &prm_sink, ///< The sink to which the value should be written
+	                   uint64_t  prm_value ///< The value to write
+	                   ) {
+		char   bytes[ 10 ];
+		size_t num_bytes = 0;
+		do {
+			const auto low_bits = static_cast<unsigned char>( prm_value & 0x7Fu );
+			prm_value >>= 7;
+			bytes[ num_bytes++ ] = static_cast<char>( ( prm_value != 0 ) ? ( low_bits | 0x80u ) : low_bits );
+		} while ( prm_value != 0 );
+		prm_sink.write( bytes, num_bytes );
+	}
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_SINK_FORMATTING_HPP
@@ -0,0 +1,124 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_THROW_RECORD_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_THROW_RECORD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include <boost/optional.hpp>
+
+#include "tell/capture_policy.hpp"
+#include "tell/detail/bounded_stacktrace.hpp"
+#include "tell/detail/raw_frames.hpp"
+#include "tell/detail/set_once_string.hpp"
+#include "tell/detail/sink_formatting.hpp"
+#include "tell/detail/types.hpp"
+#include "tell/output_sinks.hpp"
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief The single record that TELL_THROW() attaches to an exception: the captured frames
+	///        (which know whether they were truncated) or else the capture_policy that skipped the capture
+	///
+	/// Each boost::error_info attached to an exception costs several allocations (for its value, the value's
+	/// shared_ptr control block and its node in the exception's map) and a map lookup to retrieve, so everything
+	/// tell records about the stack goes in this one record. The throw location isn't in it because Boost
+	/// Exception already stores boost::throw_function, boost::throw_file and boost::throw_line in dedicated
+	/// members of boost::exception, without any allocation.
+	template <typename Frames>
+	class throw_record final {
+	private:
+		/// \brief The captured frames, or none if the capture was skipped
+		::boost::optional<Frames>         frames;
+
+		/// \brief The capture_policy that skipped the capture, or none if the frames were captured
+		::boost::optional<capture_policy> capture_skipped_by;
+
+		/// \brief The memoized description of the captured frames (or of why they weren't captured), set on the first render
+		///
+		/// Only the stacktrace section is memoized because it can't change after the throw, whereas the rest of
+		/// an exception's description (its throw location, dynamic type and what()) can differ between renders
+		/// (eg if a handler adds a new throw location or if a copy with a different dynamic type shares this record).
+		/// The slot can be set on a const throw_record because Boost Exception only gives const access to a caught
+		/// exception's error_info values.
+		set_once_string rendered_stacktrace;
+
+	public:
+		/// \brief Make a throw_record of the specified captured frames
+		static throw_record captured(Frames &&prm_frames ///< The captured frames
+		                             ) {
+			throw_record result;
+			result.frames = ::std::move( prm_frames );
+			return result;
+		}
+
+		/// \brief Make a throw_record of a capture that was skipped by the specified capture_policy
+		static throw_record skipped(const capture_policy &prm_policy ///< The capture_policy that skipped the capture
+		                            ) {
+			throw_record result;
+			result.capture_skipped_by = prm_policy;
+			return result;
+		}
+
+		/// \brief Get the captured frames, or nullptr if the capture was skipped
+		const Frames * get_frames() const noexcept {
+			return frames.get_ptr();
+		}
+
+		/// \brief Get the number of frames kept if the captured frames were truncated, or none otherwise
+		::boost::optional<size_t> get_truncation() const noexcept {
+			if ( frames && frames->is_truncated() ) {
+				return frames->size();
+			}
+			return ::boost::none;
+		}
+
+		/// \brief Get the capture_policy that skipped the capture, or none if the frames were captured
+		const ::boost::optional<capture_policy> & get_capture_skipped_by() const noexcept {
+			return capture_skipped_by;
+		}
+
+		/// \brief Get the memoized description of the captured frames, or nullptr if they haven't been rendered yet
+		const ::std::string * get_rendered_stacktrace() const noexcept {
+			return rendered_stacktrace.get();
+		}
+
+		/// \brief Memoize the specified description of the captured frames, unless another thread has already done so
+		///
+		/// \returns The memoized description (which is the other thread's, if it got there first)
+		const ::std::string & set_rendered_stacktrace(::std::string prm_description ///< The description of the captured frames (or of why they weren't captured)
+		                                              ) const {
+			return rendered_stacktrace.set( ::std::move( prm_description ) );
+		}
+	};
+
+	/// \brief Generate a brief description of the specified throw_record (without symbolizing any frames)
+	///
+	/// This is found by Boost Exception's boost::diagnostic_information() for describing the error_info
+	template <typename Frames>
+	::std::string to_string(const throw_record<Frames> &prm_record ///< The throw_record to describe
+	                        ) {
+		::std::string result;
+		string_sink   sink{ result };
+		if ( const Frames * const frames_ptr = prm_record.get_frames() ) {
+			write_decimal( sink, static_cast<int64_t>( frames_ptr->size() ) );
+			write_cstring( sink, frames_ptr->is_truncated() ? " frames (truncated):" : " frames:" );
+			for (const auto &frame : *frames_ptr) {
+				write_cstring( sink, " " );
+				write_hex    ( sink, reinterpret_cast<uintptr_t>( frame_address( frame ) ) );
+			}
+		}
+		else if ( prm_record.get_capture_skipped_by() ) {
+			write_cstring( sink, "not captured (skipped by capture policy: " );
+			write_string ( sink, to_string( *prm_record.get_capture_skipped_by() ) );
+			write_cstring( sink, ")" );
+		}
+		return result;
+	}
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_THROW_RECORD_HPP
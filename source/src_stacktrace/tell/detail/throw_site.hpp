@@ -0,0 +1,131 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_THROW_SITE_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_THROW_SITE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#include "tell/capture_policy.hpp"
+#include "tell/detail/types.hpp"
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief The state of a single TELL_THROW() site, used to decide whether (and how deeply) to capture a stacktrace
+	///
+	/// Each TELL_THROW() expansion has its own static instance of this (constant-initialized, so with
+	/// no guard). All the decisions are made with lock-free atomic operations; the only lock is taken
+	/// to (re-)resolve the site's policy and depth when the capture_policy_registry has changed.
+	class throw_site final {
+	private:
+		/// \brief The number of low bits of window used for the count of captures in the current second
+		static constexpr unsigned window_count_bits = 24;
+
+		/// \brief The file of the site
+		const char * const       file;
+
+		/// \brief The line of the site
+		const throw_line_value_t line;
+
+		/// \brief The registry generation to which packed_policy and packed_depth correspond
+		::std::atomic<uint64_t>  policy_generation{ ::std::numeric_limits<uint64_t>::max() };
+
+		/// \brief The site's current policy, packed by capture_policy::pack()
+		::std::atomic<uint64_t>  packed_policy{ capture_policy::always().pack() };
+
+		/// \brief The site's current depth, packed by capture_depth::pack()
+		::std::atomic<uint64_t>  packed_depth{ capture_depth::unlimited().pack() };
+
+		/// \brief The number of throws from this site
+		::std::atomic<uint64_t>  num_throws{ 0 };
+
+		/// \brief The current one-second window (in the high bits) and the number of captures within it (in the low bits)
+		::std::atomic<uint64_t>  window{ 0 };
+
+		/// \brief Decide whether to capture under an AT_MOST_PER_SECOND policy with the specified limit
+		bool take_from_window(const uint64_t &prm_limit ///< The maximum number of captures per second
+		                      ) {
+			constexpr uint64_t count_mask  = ( static_cast<uint64_t>( 1 ) << window_count_bits ) - 1;
+			const     uint64_t limit       = ( prm_limit < count_mask ) ? prm_limit : count_mask;
+			const     uint64_t now_seconds = static_cast<uint64_t>( ::std::chrono::duration_cast<::std::chrono::seconds>(
+				::std::chrono::steady_clock::now().time_since_epoch()
+			).count() );
+
+			uint64_t current = window.load( ::std::memory_order_relaxed );
+			while ( true ) {
+				const bool     same_second = ( ( current >> window_count_bits ) == now_seconds );
+				const uint64_t count       = same_second ? ( current & count_mask ) : 0;
+				if ( count >= limit ) {
+					return false;
+				}
+				const uint64_t replacement = ( now_seconds << window_count_bits ) | ( count + 1 );
+				if ( window.compare_exchange_weak( current, replacement, ::std::memory_order_relaxed ) ) {
+					return true;
+				}
+			}
+		}
+
+	public:
+		/// \brief Ctor from the file and line of the site
+		constexpr throw_site(const char * const       prm_file, ///< The file of the site
+		                     const throw_line_value_t prm_line  ///< The line of the site
+		                     ) : file{ prm_file },
+		                         line{ prm_line } {
+		}
+
+		/// \brief Re-resolve the site's policy and depth if the registry has changed since they were last resolved
+		///
+		/// The new values are stored while the registry's lock is held (see capture_policy_registry::resolve())
+		/// so that an older resolution can't overwrite a newer one. If the policy has changed, the count of throws
+		/// is restarted so that the new policy applies from its installation (rather than to the site's whole history).
+		void refresh() {
+			auto       &registry   = capture_policy_registry::instance();
+			const auto  generation = registry.get_generation();
+			if ( policy_generation.load( ::std::memory_order_acquire ) != generation ) {
+				registry.resolve( file, line, [&] (const resolved_site_capture &prm_resolved) {
+					if ( policy_generation.load( ::std::memory_order_relaxed ) == prm_resolved.generation ) {
+						return;
+					}
+					if ( packed_policy.load( ::std::memory_order_relaxed ) != prm_resolved.packed_policy ) {
+						num_throws.store( 0, ::std::memory_order_relaxed );
+						packed_policy.store( prm_resolved.packed_policy, ::std::memory_order_relaxed );
+					}
+					packed_depth.store( prm_resolved.packed_depth, ::std::memory_order_relaxed );
+					policy_generation.store( prm_resolved.generation, ::std::memory_order_release );
+				} );
+			}
+		}
+
+		/// \brief Get the site's current policy, re-resolving it if the registry has changed
+		capture_policy get_policy() {
+			refresh();
+			return capture_policy::unpack( packed_policy.load( ::std::memory_order_relaxed ) );
+		}
+
+		/// \brief Get the site's current depth, re-resolving it if the registry has changed
+		capture_depth get_depth() {
+			refresh();
+			return capture_depth::unpack( packed_depth.load( ::std::memory_order_relaxed ) );
+		}
+
+		/// \brief Record a throw from this site and return whether a stacktrace should be captured for it
+		bool should_capture() {
+			const auto policy = get_policy();
+			switch ( policy.get_kind() ) {
+				case capture_policy::kind::ALWAYS             : { return true; }
+				case capture_policy::kind::EVERY_NTH          : { return ( num_throws.fetch_add( 1, ::std::memory_order_relaxed ) % policy.get_limit() ) == 0; }
+				case capture_policy::kind::FIRST_N            : { return ( num_throws.fetch_add( 1, ::std::memory_order_relaxed ) < policy.get_limit() ); }
+				case capture_policy::kind::AT_MOST_PER_SECOND : { return take_from_window( policy.get_limit() ); }
+			}
+			return true;
+		}
+	};
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+/// \brief Get a reference to the static throw_site for the site at which this macro is expanded
+#define TELL_DETAIL_THROW_SITE() ( [] () -> ::tell::except::detail::throw_site & { static ::tell::except::detail::throw_site the_site{ __FILE__, __LINE__ }; return the_site; } () )
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_THROW_SITE_HPP
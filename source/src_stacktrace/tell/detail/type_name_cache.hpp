@@ -0,0 +1,67 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_TYPE_NAME_CACHE_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_TYPE_NAME_CACHE_HPP
+
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+
+#include <boost/core/demangle.hpp>
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief A thread-safe, process-wide cache of the demangled names of types
+	///
+	/// Demangling allocates and walks the whole mangled name, so doing it once per type rather
+	/// than once per retrieval matters when the same exception types are described repeatedly.
+	/// The number of exception types in a program is small, so nothing is ever evicted; that means
+	/// the references returned remain valid (and unchanged) for the life of the process.
+	///
+	/// Use instance() to get the process-wide cache.
+	class type_name_cache final {
+	private:
+		/// \brief Mutex to protect names
+		::std::mutex mutex;
+
+		/// \brief The demangled names of the types seen so far
+		::std::unordered_map<::std::type_index, ::std::string> names;
+
+	public:
+		/// \brief Get the demangled name of the specified type (or its mangled name if it can't be demangled)
+		const ::std::string & demangled_name(const ::std::type_info &prm_type ///< The type to query
+		                                     ) {
+			const ::std::type_index type_index{ prm_type };
+			{
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				const auto find_itr = names.find( type_index );
+				if ( find_itr != names.end() ) {
+					return find_itr->second;
+				}
+			}
+
+			// Demangle outside the lock so that it doesn't stall other threads' hits
+			::std::string name = ::boost::core::demangle( prm_type.name() );
+
+			const ::std::lock_guard<::std::mutex> lock{ mutex };
+			return names.emplace( type_index, ::std::move( name ) ).first->second;
+		}
+
+		/// \brief Get the process-wide type_name_cache
+		static type_name_cache & instance() {
+			static type_name_cache the_instance;
+			return the_instance;
+		}
+	};
+
+	/// \brief Get the demangled name of the specified type, via the process-wide type_name_cache
+	inline const ::std::string & demangled_type_name(const ::std::type_info &prm_type ///< The type to query
+	                                                 ) {
+		return type_name_cache::instance().demangled_name( prm_type );
+	}
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_TYPE_NAME_CACHE_HPP
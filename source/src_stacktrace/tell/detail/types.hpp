@@ -1,11 +1,22 @@
 #ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_TYPES_HPP
 #define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_TYPES_HPP
 
+#include <cstddef>
+
 #include <boost/exception/info.hpp>
-#include <boost/stacktrace/stacktrace_fwd.hpp>
+
+#include "tell/detail/config.hpp"
 
 namespace tell { namespace except { namespace detail {
 
+	template <size_t Capacity>
+	class raw_frames;
+
+	class bounded_stacktrace;
+
+	template <typename Frames>
+	class throw_record;
+
 	/// \brief Type alias for the type that Boost Exception's boost::throw_function uses to store the name of the function containing the code that wants to throw
 	using throw_function_value_t = typename ::boost::throw_function::value_type;
 
@@ -15,18 +26,24 @@ namespace tell { namespace except { namespace detail {
 	/// \brief Type alias for the type that Boost Exception's boost::throw_line uses to store the number of the source line containing the code that wants to throw
 	using throw_line_value_t     = typename ::boost::throw_line::value_type;
 
-	/// \brief A tag to use in a boost::error_info as a key that indicates a stacktrace value
-	struct boost_exception_stacktrace_tag final {
-		boost_exception_stacktrace_tag() = delete;
-		~boost_exception_stacktrace_tag() = delete;
-		boost_exception_stacktrace_tag(const boost_exception_stacktrace_tag &) = delete;
-		boost_exception_stacktrace_tag(boost_exception_stacktrace_tag &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
-		boost_exception_stacktrace_tag & operator=(const boost_exception_stacktrace_tag &) = delete;
-		boost_exception_stacktrace_tag & operator=(boost_exception_stacktrace_tag &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
+	/// \brief Type alias for the raw_frames type that TELL_THROW() uses when TELL_USE_RAW_FRAMES is defined
+	using raw_frames_t = raw_frames<TELL_RAW_FRAMES_CAPACITY>;
+
+	/// \brief A tag to use in a boost::error_info as a key that indicates a throw_record value
+	struct boost_exception_throw_record_tag final {
+		boost_exception_throw_record_tag() = delete;
+		~boost_exception_throw_record_tag() = delete;
+		boost_exception_throw_record_tag(const boost_exception_throw_record_tag &) = delete;
+		boost_exception_throw_record_tag(boost_exception_throw_record_tag &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
+		boost_exception_throw_record_tag & operator=(const boost_exception_throw_record_tag &) = delete;
+		boost_exception_throw_record_tag & operator=(boost_exception_throw_record_tag &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
 	};
 
-	/// \brief An error_info that stores a stacktrace under the boost_exception_stacktrace_tag tag
-	using boost_exception_stacktrace_error_info = ::boost::error_info<boost_exception_stacktrace_tag, ::boost::stacktrace::stacktrace>;
+	/// \brief An error_info that stores a throw_record of frames captured as a bounded_stacktrace, under the boost_exception_throw_record_tag tag
+	using boost_exception_stacktrace_record_error_info = ::boost::error_info<boost_exception_throw_record_tag, throw_record<bounded_stacktrace>>;
+
+	/// \brief An error_info that stores a throw_record of frames captured as a raw_frames_t, under the boost_exception_throw_record_tag tag
+	using boost_exception_raw_frames_record_error_info = ::boost::error_info<boost_exception_throw_record_tag, throw_record<raw_frames_t>>;
 
 } // namespace detail
 } // namespace except
@@ -0,0 +1,38 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_WRITE_FULLY_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_WRITE_FULLY_HPP
+
+#include <cerrno>
+#include <cstddef>
+
+#include <unistd.h>
+
+namespace tell { namespace except { namespace detail {
+
+	/// \brief Write all of the specified chars to the specified file descriptor, retrying on partial writes and EINTR
+	///
+	/// In the normal case, this is a single write(2)
+	///
+	/// \returns Whether all of the chars were written (rather than write(2) failing part way through)
+	inline bool write_fully(const int          &prm_fd,       ///< The file descriptor to which the chars should be written
+	                        const char         *prm_chars,    ///< The chars to write
+	                        size_t              prm_num_chars ///< The number of chars to write
+	                        ) noexcept {
+		while ( prm_num_chars > 0 ) {
+			const ssize_t num_written = ::write( prm_fd, prm_chars, prm_num_chars );
+			if ( num_written < 0 ) {
+				if ( errno == EINTR ) {
+					continue;
+				}
+				return false;
+			}
+			prm_chars     += num_written;
+			prm_num_chars -= static_cast<size_t>( num_written );
+		}
+		return true;
+	}
+
+} // namespace detail
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_DETAIL_WRITE_FULLY_HPP
@@ -0,0 +1,118 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_ELF_SYMBOLIZER_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_ELF_SYMBOLIZER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "tell/detail/elf_module_index.hpp"
+#include "tell/detail/loaded_module_map.hpp"
+#include "tell/symbol_info.hpp"
+
+namespace tell { namespace except {
+
+	/// \brief An in-process symbolizer that reads the loaded modules' ELF symbol tables and DWARF line tables
+	///
+	/// This is an alternative to Boost Stacktrace's backends (particularly the addr2line backend,
+	/// which spawns a process for each query). Each loaded module is mmap'd and indexed once, on the
+	/// first lookup of an address within it, after which each lookup is a pair of binary searches.
+	/// The module containing each address is found via the loaded_module_map, without calling into the dynamic loader.
+	///
+	/// Define TELL_USE_ELF_SYMBOLIZER to make tell's stacktrace rendering use this.
+	///
+	/// Use instance() to get the process-wide symbolizer.
+	class elf_symbolizer final {
+	private:
+		/// \brief The lazily-built index of a loaded module's symbols and lines
+		struct module_index final {
+			/// \brief Flag to ensure index is built exactly once
+			::std::once_flag                                  index_flag;
+
+			/// \brief The index of the module's symbols and lines, built on first use
+			::std::unique_ptr<const detail::elf_module_index> index;
+
+			/// \brief Get the index, building it from the specified module's file if this is the first use
+			const detail::elf_module_index & get(const detail::loaded_module_info &prm_module ///< The module whose index this is
+			                                     ) {
+				::std::call_once( index_flag, [&] {
+					index = ::std::make_unique<const detail::elf_module_index>(
+						prm_module.is_main_program ? ::std::string{ "/proc/self/exe" } : prm_module.path
+					);
+				} );
+				return *index;
+			}
+		};
+
+		/// \brief Mutex to protect indices and indexed_generation
+		::std::mutex mutex;
+
+		/// \brief The indices of the modules that have been looked up, keyed by the loaded_module_map's loaded_module_info
+		///
+		/// The loaded_module_map keeps the same loaded_module_info for a module across its snapshots
+		/// so each module is indexed once however many modules are loaded or unloaded afterwards.
+		::std::unordered_map<detail::loaded_module_info_cptr, ::std::shared_ptr<module_index>> indices;
+
+		/// \brief The generation of the newest loaded_module_snapshot against which indices has been pruned
+		uint64_t indexed_generation = 0;
+
+		/// \brief Get the index for the specified module, creating it (unbuilt) if this is the first lookup in the module
+		///
+		/// If the snapshot is newer than any seen before, this first drops the indices of modules that
+		/// aren't in it (ie that have been unloaded), which unmaps their files once any in-flight lookups finish.
+		::std::shared_ptr<module_index> index_of(const detail::loaded_module_info_cptr     &prm_module,  ///< The module to query
+		                                         const detail::loaded_module_snapshot_cptr &prm_snapshot ///< The snapshot in which the module was found
+		                                         ) {
+			const ::std::lock_guard<::std::mutex> lock{ mutex };
+			if ( prm_snapshot->get_generation() > indexed_generation ) {
+				indexed_generation = prm_snapshot->get_generation();
+				const auto &modules = prm_snapshot->get_modules();
+				for (auto index_itr = indices.begin(); index_itr != indices.end(); ) {
+					if ( ::std::find( modules.begin(), modules.end(), index_itr->first ) == modules.end() ) {
+						index_itr = indices.erase( index_itr );
+					}
+					else {
+						++index_itr;
+					}
+				}
+			}
+			auto &the_index = indices[ prm_module ];
+			if ( ! the_index ) {
+				the_index = ::std::make_shared<module_index>();
+			}
+			return the_index;
+		}
+
+	public:
+		/// \brief Symbolize the specified address
+		///
+		/// If the address isn't in any loaded module, the result is empty
+		symbol_info symbolize(const void * const prm_address ///< The address to symbolize
+		                      ) {
+			const auto address    = reinterpret_cast<uintptr_t>( prm_address );
+			auto      &module_map = detail::loaded_module_map::instance();
+			const auto the_module = module_map.find_shared( address );
+			if ( ! the_module ) {
+				return {};
+			}
+			// find_shared() leaves the thread's snapshot as the one in which it found the module
+			const detail::loaded_module_snapshot_cptr the_snapshot = module_map.snapshot();
+			symbol_info result = index_of( the_module, the_snapshot )->get( *the_module ).lookup( address - the_module->load_bias );
+			result.module        = the_module->name;
+			result.module_offset = address - the_module->load_bias;
+			return result;
+		}
+
+		/// \brief Get the process-wide elf_symbolizer
+		static elf_symbolizer & instance() {
+			static elf_symbolizer the_instance;
+			return the_instance;
+		}
+	};
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_ELF_SYMBOLIZER_HPP
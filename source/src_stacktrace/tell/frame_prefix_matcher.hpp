@@ -0,0 +1,74 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_FRAME_PREFIX_MATCHER_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_FRAME_PREFIX_MATCHER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tell { namespace except {
+
+	/// \brief A matcher of function names against a set of prefixes, compiled once so it can be reused across frames and stacktraces
+	///
+	/// The prefixes are stored sorted with any redundant prefixes (ie those that start with another of the
+	/// prefixes) removed. Then the only candidate match for a name is the greatest prefix that's not
+	/// greater than the name, so each query is a binary search and a single comparison.
+	class frame_prefix_matcher final {
+	private:
+		/// \brief The sorted, non-redundant prefixes
+		::std::vector<::std::string> prefixes;
+
+	public:
+		/// \brief Default ctor, which matches nothing
+		frame_prefix_matcher() = default;
+
+		/// \brief Ctor from a range of prefixes (each of which must be convertible to a std::string)
+		///
+		/// This is disabled for frame_prefix_matcher itself so it doesn't hijack copies from non-const lvalues
+		template <typename Rng,
+		          typename = ::std::enable_if_t< ! ::std::is_same< ::std::remove_cv_t< ::std::remove_reference_t< Rng > >, frame_prefix_matcher >::value > >
+		explicit frame_prefix_matcher(Rng &&prm_prefixes ///< The prefixes of the function names to be matched
+		                              ) {
+			for (const auto &prefix : prm_prefixes) {
+				prefixes.emplace_back( prefix );
+			}
+			::std::sort( prefixes.begin(), prefixes.end() );
+
+			// After sorting, any prefix that starts with an earlier one follows a kept prefix that it starts with,
+			// so keep each prefix only if it doesn't start with the last one kept
+			size_t num_kept = 0;
+			for (auto &prefix : prefixes) {
+				if ( num_kept == 0 || prefix.compare( 0, prefixes[ num_kept - 1 ].size(), prefixes[ num_kept - 1 ] ) != 0 ) {
+					if ( &prefix != &prefixes[ num_kept ] ) {
+						prefixes[ num_kept ] = ::std::move( prefix );
+					}
+					++num_kept;
+				}
+			}
+			prefixes.erase( ::std::next( prefixes.begin(), static_cast<ptrdiff_t>( num_kept ) ), prefixes.end() );
+		}
+
+		/// \brief Whether this matches nothing
+		bool empty() const {
+			return prefixes.empty();
+		}
+
+		/// \brief Whether the specified function name starts with any of the prefixes
+		bool matches(const ::std::string &prm_name ///< The function name to test
+		             ) const {
+			const auto upper_itr = ::std::upper_bound( prefixes.begin(), prefixes.end(), prm_name );
+			if ( upper_itr == prefixes.begin() ) {
+				return false;
+			}
+			const auto &candidate = *::std::prev( upper_itr );
+			return ( prm_name.compare( 0, candidate.size(), candidate ) == 0 );
+		}
+	};
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_FRAME_PREFIX_MATCHER_HPP
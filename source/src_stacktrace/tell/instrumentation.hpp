@@ -0,0 +1,524 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_INSTRUMENTATION_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_INSTRUMENTATION_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "tell/detail/config.hpp"
+#include "tell/detail/types.hpp"
+
+/// \file
+/// \brief Optional per-site statistics on the costs of TELL_THROW(), exception rendering and assertion failures
+///
+/// This is only compiled in if TELL_ENABLE_INSTRUMENTATION is defined (see config.hpp); otherwise
+/// nothing is recorded and get_instrumentation_snapshot() returns an empty snapshot.
+///
+/// Each thread records into its own table of counters, which only it writes, so recording never takes
+/// a lock or contends with other threads. A snapshot aggregates the tables on demand: it reads each
+/// under a sequence lock (retrying if the owner updated it mid-read) so it gets a consistent view of each
+/// thread's counters without ever blocking the threads that are recording.
+
+namespace tell { namespace except {
+
+	/// \brief The kinds of site for which statistics are recorded
+	enum class site_kind : uint8_t {
+		THROW,    ///< A TELL_THROW() site (with the renders of exceptions thrown from it)
+		ASSERTION ///< A BOOST_ASSERT() / BOOST_ASSERT_MSG() site
+	};
+
+	/// \brief Generate a string describing the specified site_kind
+	inline ::std::string to_string(const site_kind &prm_kind ///< The kind to describe
+	                               ) {
+		switch ( prm_kind ) {
+			case site_kind::THROW     : { return "throw";     }
+			case site_kind::ASSERTION : { return "assertion"; }
+		}
+		return "unknown";
+	}
+
+	/// \brief The statistics of a single site, summed over all threads
+	///
+	/// The counters are cumulative since the start of the process, so an exporter that wants
+	/// rates should take the differences between successive snapshots.
+	struct site_statistics final {
+		/// \brief The kind of site
+		site_kind                  kind                = site_kind::THROW;
+
+		/// \brief The name of the function containing the site (or empty if it has only been seen by renders)
+		::std::string              function;
+
+		/// \brief The file of the site (as spelled by __FILE__ at the site)
+		::std::string              file;
+
+		/// \brief The line of the site
+		detail::throw_line_value_t line                = 0;
+
+		/// \brief The number of throws (or assertion failures) at the site
+		uint64_t                   num_occurrences     = 0;
+
+		/// \brief The number of those for which a stacktrace was captured
+		uint64_t                   num_captures        = 0;
+
+		/// \brief The total time spent capturing stacktraces, in nanoseconds
+		uint64_t                   capture_ns          = 0;
+
+		/// \brief The total number of frames captured
+		uint64_t                   num_captured_frames = 0;
+
+		/// \brief The largest number of frames captured in any one stacktrace
+		uint64_t                   max_captured_frames = 0;
+
+		/// \brief The number of renders (eg by retrieve_exception_info()) of exceptions thrown from the site
+		///        (or of the assertion failure)
+		uint64_t                   num_renders         = 0;
+
+		/// \brief The total time spent rendering (including symbolizing), in nanoseconds
+		uint64_t                   render_ns           = 0;
+	};
+
+	/// \brief A consistent snapshot of the statistics of every site
+	struct instrumentation_snapshot final {
+		/// \brief The statistics of each site, ordered by kind, file and line
+		::std::vector<site_statistics> sites;
+
+		/// \brief The statistics that couldn't be attributed to a site, either because a thread's table was full
+		///        or because a rendered exception had no throw location
+		site_statistics                untracked;
+
+		/// \brief The number of thread tables that were aggregated
+		size_t                         num_thread_tables = 0;
+	};
+
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+
+	namespace detail {
+
+		/// \brief Type alias for the clock used to time the instrumented operations
+		using instrumentation_clock = ::std::chrono::steady_clock;
+
+		/// \brief Get the number of nanoseconds since the specified time
+		inline uint64_t nanoseconds_since(const instrumentation_clock::time_point &prm_start ///< The start time
+		                                  ) {
+			return static_cast<uint64_t>( ::std::chrono::duration_cast<::std::chrono::nanoseconds>( instrumentation_clock::now() - prm_start ).count() );
+		}
+
+		/// \brief Add the specified value to the specified counter, which must only be written by the calling thread
+		///
+		/// Since there's a single writer, this needn't be an atomic read-modify-write (which would be much more expensive)
+		inline void add_to_owned_counter(::std::atomic<uint64_t> &prm_counter, ///< The counter
+		                                 const uint64_t          &prm_value    ///< The value to add
+		                                 ) {
+			prm_counter.store( prm_counter.load( ::std::memory_order_relaxed ) + prm_value, ::std::memory_order_relaxed );
+		}
+
+		/// \brief Add the counters of the specified site_statistics to those of another
+		inline void add_counters(site_statistics       &prm_to,  ///< The statistics to which the counters should be added
+		                         const site_statistics &prm_from ///< The statistics whose counters should be added
+		                         ) {
+			prm_to.num_occurrences     += prm_from.num_occurrences;
+			prm_to.num_captures        += prm_from.num_captures;
+			prm_to.capture_ns          += prm_from.capture_ns;
+			prm_to.num_captured_frames += prm_from.num_captured_frames;
+			prm_to.num_renders         += prm_from.num_renders;
+			prm_to.render_ns           += prm_from.render_ns;
+			if ( prm_from.max_captured_frames > prm_to.max_captured_frames ) {
+				prm_to.max_captured_frames = prm_from.max_captured_frames;
+			}
+		}
+
+		/// \brief Type alias for a map from site (kind, file and line) to its statistics
+		using site_statistics_map = ::std::map<::std::tuple<site_kind, ::std::string, throw_line_value_t>, site_statistics>;
+
+		/// \brief The counters of a single site in a single thread's table
+		///
+		/// Everything's atomic so that snapshots can read while the owning thread writes; only the owning thread writes.
+		struct instrumentation_slot final {
+			/// \brief The file of the site, or nullptr if this slot is unclaimed
+			::std::atomic<const char *>       file               { nullptr };
+
+			/// \brief The name of the function containing the site, or nullptr if not yet known
+			::std::atomic<const char *>       function           { nullptr };
+
+			/// \brief The line of the site
+			::std::atomic<throw_line_value_t> line               { 0 };
+
+			/// \brief The kind of the site
+			::std::atomic<site_kind>          kind               { site_kind::THROW };
+
+			/// \brief The number of throws (or assertion failures)
+			::std::atomic<uint64_t>           num_occurrences    { 0 };
+
+			/// \brief The number of stacktrace captures
+			::std::atomic<uint64_t>           num_captures       { 0 };
+
+			/// \brief The total capture time in nanoseconds
+			::std::atomic<uint64_t>           capture_ns         { 0 };
+
+			/// \brief The total number of frames captured
+			::std::atomic<uint64_t>           num_captured_frames{ 0 };
+
+			/// \brief The largest number of frames captured in one stacktrace
+			::std::atomic<uint64_t>           max_captured_frames{ 0 };
+
+			/// \brief The number of renders
+			::std::atomic<uint64_t>           num_renders        { 0 };
+
+			/// \brief The total render time in nanoseconds
+			::std::atomic<uint64_t>           render_ns          { 0 };
+
+			/// \brief Record a capture of the specified number of frames that took the specified time
+			void record_capture(const uint64_t &prm_ns,        ///< The time taken, in nanoseconds
+			                    const uint64_t &prm_num_frames ///< The number of frames captured
+			                    ) {
+				add_to_owned_counter( num_captures,        1              );
+				add_to_owned_counter( capture_ns,          prm_ns         );
+				add_to_owned_counter( num_captured_frames, prm_num_frames );
+				if ( prm_num_frames > max_captured_frames.load( ::std::memory_order_relaxed ) ) {
+					max_captured_frames.store( prm_num_frames, ::std::memory_order_relaxed );
+				}
+			}
+
+			/// \brief Record a render that took the specified time
+			void record_render(const uint64_t &prm_ns ///< The time taken, in nanoseconds
+			                   ) {
+				add_to_owned_counter( num_renders, 1      );
+				add_to_owned_counter( render_ns,   prm_ns );
+			}
+
+			/// \brief Add this slot's counters to the specified site_statistics
+			void add_to(site_statistics &prm_statistics ///< The statistics to which the counters should be added
+			            ) const {
+				const uint64_t max_frames = max_captured_frames.load( ::std::memory_order_relaxed );
+				prm_statistics.num_occurrences     += num_occurrences    .load( ::std::memory_order_relaxed );
+				prm_statistics.num_captures        += num_captures       .load( ::std::memory_order_relaxed );
+				prm_statistics.capture_ns          += capture_ns         .load( ::std::memory_order_relaxed );
+				prm_statistics.num_captured_frames += num_captured_frames.load( ::std::memory_order_relaxed );
+				prm_statistics.num_renders         += num_renders        .load( ::std::memory_order_relaxed );
+				prm_statistics.render_ns           += render_ns          .load( ::std::memory_order_relaxed );
+				if ( max_frames > prm_statistics.max_captured_frames ) {
+					prm_statistics.max_captured_frames = max_frames;
+				}
+			}
+		};
+
+		/// \brief A single thread's table of per-site counters
+		///
+		/// The owning thread brackets each update with increments of a sequence number (so it's odd
+		/// mid-update); a reader retries until it reads the same even sequence number before and after.
+		class thread_instrumentation_table final {
+		private:
+			/// \brief The number of slots (a power of two, for cheap probing)
+			static constexpr size_t num_slots = TELL_INSTRUMENTATION_SLOTS;
+
+			static_assert( num_slots > 0 && ( num_slots & ( num_slots - 1 ) ) == 0, "TELL_INSTRUMENTATION_SLOTS must be a power of two" );
+
+			/// \brief The sequence number, which is odd while the owning thread is updating the table
+			::std::atomic<uint64_t>                      sequence{ 0 };
+
+			/// \brief The slots, keyed by (kind, file, line) with open addressing
+			::std::array<instrumentation_slot, num_slots> slots;
+
+			/// \brief The slot for anything that can't be attributed to a site
+			instrumentation_slot                         untracked;
+
+			/// \brief Find the slot for the specified site, claiming one if need be
+			///
+			/// Sites are identified by the address of their __FILE__ literal (rather than its contents) so that
+			/// this is cheap; snapshots merge any sites that the compiler gave duplicate literals.
+			instrumentation_slot & find_slot(const site_kind          &prm_kind,     ///< The kind of the site
+			                                 const char       * const  prm_function, ///< The name of the function containing the site, or nullptr if not known
+			                                 const char       * const  prm_file,     ///< The file of the site, or nullptr if not known
+			                                 const throw_line_value_t &prm_line      ///< The line of the site
+			                                 ) {
+				if ( prm_file == nullptr ) {
+					return untracked;
+				}
+				const size_t hash = ( reinterpret_cast<uintptr_t>( prm_file ) >> 3 )
+				                  ^ ( static_cast<size_t>( prm_line ) * 0x9E3779B97F4A7C15u )
+				                  ^ static_cast<size_t>( prm_kind );
+				for (size_t probe_ctr = 0; probe_ctr < num_slots; ++probe_ctr) {
+					auto &slot = slots[ ( hash + probe_ctr ) & ( num_slots - 1 ) ];
+					const char * const slot_file = slot.file.load( ::std::memory_order_relaxed );
+					if ( slot_file == nullptr ) {
+						slot.kind.store( prm_kind, ::std::memory_order_relaxed );
+						slot.line.store( prm_line, ::std::memory_order_relaxed );
+						slot.function.store( prm_function, ::std::memory_order_relaxed );
+						slot.file.store( prm_file, ::std::memory_order_relaxed );
+						return slot;
+					}
+					if ( slot_file == prm_file && slot.line.load( ::std::memory_order_relaxed ) == prm_line && slot.kind.load( ::std::memory_order_relaxed ) == prm_kind ) {
+						if ( prm_function != nullptr && slot.function.load( ::std::memory_order_relaxed ) == nullptr ) {
+							slot.function.store( prm_function, ::std::memory_order_relaxed );
+						}
+						return slot;
+					}
+				}
+				return untracked;
+			}
+
+		public:
+			/// \brief Whether this table currently belongs to a live thread
+			::std::atomic<bool> in_use{ false };
+
+			/// \brief Update the slot for the specified site with the specified function (which is passed the slot)
+			///
+			/// This must only be called by the owning thread
+			template <typename Fn>
+			void update(const site_kind          &prm_kind,     ///< The kind of the site
+			            const char       * const  prm_function, ///< The name of the function containing the site, or nullptr if not known
+			            const char       * const  prm_file,     ///< The file of the site, or nullptr if not known
+			            const throw_line_value_t &prm_line,     ///< The line of the site
+			            Fn                      &&prm_fn        ///< The function to update the slot
+			            ) {
+				const uint64_t start_sequence = sequence.load( ::std::memory_order_relaxed );
+				sequence.store( start_sequence + 1, ::std::memory_order_relaxed );
+				::std::atomic_thread_fence( ::std::memory_order_release );
+				prm_fn( find_slot( prm_kind, prm_function, prm_file, prm_line ) );
+				sequence.store( start_sequence + 2, ::std::memory_order_release );
+			}
+
+			/// \brief Add a consistent view of this table's counters to the specified statistics, keyed by site
+			void add_to(site_statistics_map &prm_sites,    ///< The statistics of each site
+			            site_statistics     &prm_untracked ///< The statistics that couldn't be attributed to a site
+			            ) const {
+				while ( true ) {
+					const uint64_t start_sequence = sequence.load( ::std::memory_order_acquire );
+					if ( ( start_sequence % 2 ) != 0 ) {
+						::std::this_thread::yield();
+						continue;
+					}
+
+					::std::vector<site_statistics> table_sites;
+					site_statistics                table_untracked;
+					for (const auto &slot : slots) {
+						const char * const slot_file = slot.file.load( ::std::memory_order_relaxed );
+						if ( slot_file == nullptr ) {
+							continue;
+						}
+						const char * const slot_function = slot.function.load( ::std::memory_order_relaxed );
+						table_sites.emplace_back();
+						auto &site = table_sites.back();
+						site.kind     = slot.kind.load( ::std::memory_order_relaxed );
+						site.function = ( slot_function != nullptr ) ? slot_function : "";
+						site.file     = slot_file;
+						site.line     = slot.line.load( ::std::memory_order_relaxed );
+						slot.add_to( site );
+					}
+					untracked.add_to( table_untracked );
+
+					::std::atomic_thread_fence( ::std::memory_order_acquire );
+					if ( sequence.load( ::std::memory_order_relaxed ) != start_sequence ) {
+						continue;
+					}
+
+					for (auto &table_site : table_sites) {
+						auto &site = prm_sites[ ::std::make_tuple( table_site.kind, table_site.file, table_site.line ) ];
+						if ( site.file.empty() ) {
+							site.kind     = table_site.kind;
+							site.file     = table_site.file;
+							site.line     = table_site.line;
+						}
+						if ( site.function.empty() ) {
+							site.function = table_site.function;
+						}
+						add_counters( site, table_site );
+					}
+					add_counters( prm_untracked, table_untracked );
+					return;
+				}
+			}
+		};
+
+		/// \brief The process-wide registry of thread_instrumentation_tables
+		///
+		/// Tables are never freed: when a thread exits, its table is released for reuse by a
+		/// later thread, with its counters intact (so snapshots stay cumulative). The mutex is only
+		/// taken when a thread first records and when a snapshot is taken.
+		class instrumentation_registry final {
+		private:
+			/// \brief Mutex to protect tables
+			::std::mutex mutex;
+
+			/// \brief The tables
+			::std::vector<::std::unique_ptr<thread_instrumentation_table>> tables;
+
+		public:
+			/// \brief Acquire a table for the calling thread, reusing one released by an exited thread if possible
+			thread_instrumentation_table & acquire() {
+				const ::std::lock_guard<::std::mutex> lock{ mutex };
+				for (auto &table_ptr : tables) {
+					if ( ! table_ptr->in_use.load() ) {
+						table_ptr->in_use.store( true );
+						return *table_ptr;
+					}
+				}
+				tables.push_back( ::std::make_unique<thread_instrumentation_table>() );
+				tables.back()->in_use.store( true );
+				return *tables.back();
+			}
+
+			/// \brief Take a snapshot of the statistics of every site, summed over all threads
+			///
+			/// Only the table pointers are copied under the mutex (into space reserved beforehand) so that
+			/// a thread's first acquire() doesn't wait on the reading or allocating; that's safe because
+			/// tables are never freed.
+			instrumentation_snapshot snapshot() {
+				::std::vector<const thread_instrumentation_table *> table_ptrs;
+				size_t                                              num_tables = 0;
+				while ( true ) {
+					{
+						const ::std::lock_guard<::std::mutex> lock{ mutex };
+						num_tables = tables.size();
+						if ( num_tables <= table_ptrs.capacity() ) {
+							for (const auto &table_ptr : tables) {
+								table_ptrs.push_back( table_ptr.get() );
+							}
+							break;
+						}
+					}
+					table_ptrs.reserve( num_tables );
+				}
+
+				site_statistics_map      sites;
+				instrumentation_snapshot result;
+				for (const auto &table_ptr : table_ptrs) {
+					table_ptr->add_to( sites, result.untracked );
+				}
+				result.num_thread_tables = table_ptrs.size();
+				result.sites.reserve( sites.size() );
+				for (auto &site_entry : sites) {
+					result.sites.push_back( ::std::move( site_entry.second ) );
+				}
+				return result;
+			}
+
+			/// \brief Get the process-wide instrumentation_registry
+			static instrumentation_registry & instance() {
+				static instrumentation_registry the_instance;
+				return the_instance;
+			}
+		};
+
+		/// \brief A thread's lease on a thread_instrumentation_table, which releases it when the thread exits
+		class thread_instrumentation_lease final {
+		private:
+			/// \brief The leased table
+			thread_instrumentation_table &table;
+
+		public:
+			/// \brief Default ctor that acquires a table from the process-wide registry
+			thread_instrumentation_lease() : table{ instrumentation_registry::instance().acquire() } {
+			}
+
+			thread_instrumentation_lease(const thread_instrumentation_lease &) = delete;
+			thread_instrumentation_lease(thread_instrumentation_lease &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
+			thread_instrumentation_lease & operator=(const thread_instrumentation_lease &) = delete;
+			thread_instrumentation_lease & operator=(thread_instrumentation_lease &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
+
+			/// \brief Dtor that releases the table for reuse
+			~thread_instrumentation_lease() {
+				table.in_use.store( false );
+			}
+
+			/// \brief Get the leased table
+			thread_instrumentation_table & get() {
+				return table;
+			}
+		};
+
+		/// \brief Get the calling thread's thread_instrumentation_table
+		inline thread_instrumentation_table & this_thread_instrumentation_table() {
+			thread_local thread_instrumentation_lease lease;
+			return lease.get();
+		}
+
+		/// \brief Record a throw from the specified TELL_THROW() site that captured the specified number
+		///        of frames in the specified time
+		inline void record_throw(const char         * const  prm_function,   ///< The name of the function containing the site
+		                         const char         * const  prm_file,       ///< The file of the site
+		                         const throw_line_value_t   &prm_line,       ///< The line of the site
+		                         const uint64_t             &prm_capture_ns, ///< The time taken to capture the stacktrace, in nanoseconds
+		                         const uint64_t             &prm_num_frames  ///< The number of frames captured
+		                         ) {
+			this_thread_instrumentation_table().update(
+				site_kind::THROW, prm_function, prm_file, prm_line,
+				[&] (instrumentation_slot &x) {
+					add_to_owned_counter( x.num_occurrences, 1 );
+					x.record_capture( prm_capture_ns, prm_num_frames );
+				}
+			);
+		}
+
+		/// \brief Record a throw from the specified TELL_THROW() site for which the capture was skipped
+		inline void record_uncaptured_throw(const char         * const  prm_function, ///< The name of the function containing the site
+		                                    const char         * const  prm_file,     ///< The file of the site
+		                                    const throw_line_value_t   &prm_line      ///< The line of the site
+		                                    ) {
+			this_thread_instrumentation_table().update(
+				site_kind::THROW, prm_function, prm_file, prm_line,
+				[&] (instrumentation_slot &x) { add_to_owned_counter( x.num_occurrences, 1 ); }
+			);
+		}
+
+		/// \brief Record a render of an exception thrown from the specified site that took the specified time
+		inline void record_render(const char         * const  prm_file,     ///< The file of the throw site, or nullptr if not known
+		                          const throw_line_value_t   &prm_line,     ///< The line of the throw site
+		                          const uint64_t             &prm_render_ns ///< The time taken to render, in nanoseconds
+		                          ) {
+			this_thread_instrumentation_table().update(
+				site_kind::THROW, nullptr, prm_file, prm_line,
+				[&] (instrumentation_slot &x) { x.record_render( prm_render_ns ); }
+			);
+		}
+
+		/// \brief Record an assertion failure at the specified site
+		inline void record_assertion_failure(const char         * const  prm_function,   ///< The name of the function containing the assertion
+		                                     const char         * const  prm_file,       ///< The file containing the assertion
+		                                     const throw_line_value_t   &prm_line,       ///< The line of the assertion
+		                                     const uint64_t             &prm_capture_ns, ///< The time taken to capture the stacktrace, in nanoseconds
+		                                     const uint64_t             &prm_num_frames, ///< The number of frames captured
+		                                     const uint64_t             &prm_render_ns   ///< The time taken to render the failure, in nanoseconds
+		                                     ) {
+			this_thread_instrumentation_table().update(
+				site_kind::ASSERTION, prm_function, prm_file, prm_line,
+				[&] (instrumentation_slot &x) {
+					add_to_owned_counter( x.num_occurrences, 1 );
+					x.record_capture( prm_capture_ns, prm_num_frames );
+					x.record_render( prm_render_ns );
+				}
+			);
+		}
+
+	} // namespace detail
+
+	/// \brief Take a consistent snapshot of the statistics of every instrumented site, summed over all threads
+	///
+	/// This never blocks threads that are throwing, rendering or failing assertions, so a metrics exporter can poll it
+	inline instrumentation_snapshot get_instrumentation_snapshot() {
+		return detail::instrumentation_registry::instance().snapshot();
+	}
+
+#else
+
+	/// \brief Take a consistent snapshot of the statistics of every instrumented site, summed over all threads
+	///
+	/// TELL_ENABLE_INSTRUMENTATION isn't defined, so nothing is recorded and this is always empty
+	inline instrumentation_snapshot get_instrumentation_snapshot() {
+		return {};
+	}
+
+#endif
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_INSTRUMENTATION_HPP
@@ -0,0 +1,123 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_OUTPUT_SINKS_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_OUTPUT_SINKS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "tell/detail/char_buffer_writer.hpp"
+
+/// \file
+/// \brief Sinks into which tell's write_...() functions can render
+///
+/// A sink is anything with a write(const char *, const size_t &) member. Rendering into a sink
+/// avoids building intermediate strings, so a caller with its own buffer (eg a logger's preallocated
+/// ring-buffer slot) can have the text written straight into it.
+///
+/// The write_...() functions also accept a std::ostream directly.
+
+namespace tell { namespace except {
+
+	/// \brief A sink that writes to a std::ostream
+	class ostream_sink final {
+	private:
+		/// \brief The stream to which to write
+		::std::ostream * stream_ptr;
+
+	public:
+		/// \brief Ctor from the stream to which to write
+		explicit ostream_sink(::std::ostream &prm_stream ///< The stream to which to write
+		                      ) : stream_ptr{ &prm_stream } {
+		}
+
+		/// \brief Write the specified number of chars
+		void write(const char * const prm_chars,    ///< The chars to write
+		           const size_t      &prm_num_chars ///< The number of chars to write
+		           ) {
+			stream_ptr->write( prm_chars, static_cast<::std::streamsize>( prm_num_chars ) );
+		}
+	};
+
+	/// \brief A sink that appends to a std::string
+	class string_sink final {
+	private:
+		/// \brief The string to which to append
+		::std::string * string_ptr;
+
+	public:
+		/// \brief Ctor from the string to which to append
+		explicit string_sink(::std::string &prm_string ///< The string to which to append
+		                     ) : string_ptr{ &prm_string } {
+		}
+
+		/// \brief Write the specified number of chars
+		void write(const char * const prm_chars,    ///< The chars to write
+		           const size_t      &prm_num_chars ///< The number of chars to write
+		           ) {
+			string_ptr->append( prm_chars, prm_num_chars );
+		}
+	};
+
+	/// \brief A sink that writes through an output iterator of chars
+	template <typename OutItr>
+	class output_iterator_sink final {
+	private:
+		/// \brief The iterator through which to write
+		OutItr itr;
+
+	public:
+		/// \brief Ctor from the iterator through which to write
+		explicit output_iterator_sink(OutItr prm_itr ///< The iterator through which to write
+		                              ) : itr{ ::std::move( prm_itr ) } {
+		}
+
+		/// \brief Write the specified number of chars
+		void write(const char * const prm_chars,    ///< The chars to write
+		           const size_t      &prm_num_chars ///< The number of chars to write
+		           ) {
+			itr = ::std::copy( prm_chars, prm_chars + prm_num_chars, itr );
+		}
+
+		/// \brief Get the iterator, positioned after the chars written so far
+		const OutItr & get_iterator() const {
+			return itr;
+		}
+	};
+
+	/// \brief Make an output_iterator_sink from the specified output iterator
+	template <typename OutItr>
+	output_iterator_sink<OutItr> make_output_iterator_sink(OutItr prm_itr ///< The iterator through which to write
+	                                                       ) {
+		return output_iterator_sink<OutItr>{ ::std::move( prm_itr ) };
+	}
+
+	/// \brief A sink that writes into a fixed-size char buffer, truncating rather than overflowing
+	///
+	/// This never allocates; use was_truncated() to check whether everything fitted.
+	using char_buffer_sink = detail::char_buffer_writer;
+
+	namespace detail {
+
+		/// \brief Get a sink that writes to the specified std::ostream
+		inline ostream_sink as_sink(::std::ostream &prm_stream ///< The stream to which to write
+		                            ) {
+			return ostream_sink{ prm_stream };
+		}
+
+		/// \brief Get the specified sink (for any sink that isn't a std::ostream)
+		template <typename Sink,
+		          typename = ::std::enable_if_t< ! ::std::is_base_of<::std::ostream, Sink>::value > >
+		Sink & as_sink(Sink &prm_sink ///< The sink
+		               ) {
+			return prm_sink;
+		}
+
+	} // namespace detail
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_OUTPUT_SINKS_HPP
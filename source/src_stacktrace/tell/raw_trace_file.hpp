@@ -0,0 +1,483 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_RAW_TRACE_FILE_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_RAW_TRACE_FILE_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/exception/get_error_info.hpp>
+#include <boost/optional.hpp>
+
+#include "tell/capture_policy.hpp"
+#include "tell/detail/byte_reader.hpp"
+#include "tell/detail/captured_frames.hpp"
+#include "tell/detail/loaded_module_map.hpp"
+#include "tell/detail/sink_formatting.hpp"
+#include "tell/detail/types.hpp"
+#include "tell/detail/write_fully.hpp"
+#include "tell/output_sinks.hpp"
+#include "tell/retrieve_exception_info.hpp"
+
+/// \file
+/// \brief A compact, append-only binary format for unsymbolized exception traces, to be symbolized offline
+///
+/// Symbolizing is by far the most expensive part of describing an exception. Writing raw trace records
+/// instead means a process never symbolizes: each frame is stored as an offset within its module and each
+/// module is identified by its GNU build-id, so the tell_symbolize tool can symbolize the records later
+/// (on another host) against the matching binaries.
+///
+/// A raw trace file is just a sequence of records (so files can be appended to by several processes, or
+/// concatenated). Each record is the four bytes "TELR", a version byte (raw_trace_format_version), a 4-byte
+/// little-endian payload length and the payload. Within the payload, integers are unsigned LEB128 and
+/// strings are an integer length followed by the raw bytes (with no terminator):
+///
+///  * the time of writing in nanoseconds since the Unix epoch
+///  * the ID of the writing process
+///  * a set of raw_trace_flag values (which say which of the following optional items are present)
+///  * the (mangled) name of the dynamic type of the exception
+///  * [HAS_FUNCTION]    the function from which the exception was thrown
+///  * [HAS_FILE]        the file from which the exception was thrown
+///  * [HAS_LINE]        the line from which the exception was thrown
+///  * [HAS_WHAT]        the what() of the exception
+///  * [CAPTURE_SKIPPED] the capture_policy that skipped the stacktrace capture, packed by capture_policy::pack()
+///  * the number of modules and, for each, its build-id (raw bytes, possibly empty) and path
+///  * the number of frames and, for each, the number of its module (the 1-based index in the modules, or 0 if
+///    unknown) and its return address's offset from the module's load bias (or the absolute address if unknown)
+///
+/// The TRUNCATED flag indicates that the capture_depth truncated the stacktrace to the stored frames.
+
+namespace tell { namespace except {
+
+	/// \brief The version of the record format written by write_exception_info_raw_trace()
+	constexpr uint8_t raw_trace_format_version = 1;
+
+	/// \brief The flags in a raw trace record that indicate which of its optional items are present
+	enum class raw_trace_flag : uint8_t {
+		HAS_FUNCTION    = 0x01, ///< The throw function is present
+		HAS_FILE        = 0x02, ///< The throw file is present
+		HAS_LINE        = 0x04, ///< The throw line is present
+		HAS_WHAT        = 0x08, ///< The what() is present
+		CAPTURE_SKIPPED = 0x10, ///< The stacktrace capture was skipped and the capture_policy that skipped it is present
+		TRUNCATED       = 0x20  ///< The stacktrace was truncated by the capture_depth
+	};
+
+	/// \brief A module (executable or shared library) referenced by the frames of a raw trace record
+	struct raw_trace_module final {
+		/// \brief The module's GNU build-id (raw bytes), or empty if it has none
+		::std::string build_id;
+
+		/// \brief The path of the module's file on the host that wrote the record
+		::std::string path;
+	};
+
+	/// \brief A frame of a raw trace record
+	struct raw_trace_frame final {
+		/// \brief The index of the frame's module in the record's modules, or none if unknown
+		::boost::optional<size_t> module_index;
+
+		/// \brief The frame's return address's offset from its module's load bias (or the absolute address if the module is unknown)
+		uint64_t                  offset = 0;
+	};
+
+	/// \brief The contents of a raw trace record, as read by raw_trace_reader
+	struct raw_trace_record final {
+		/// \brief The time of writing in nanoseconds since the Unix epoch
+		uint64_t                              timestamp_ns = 0;
+
+		/// \brief The ID of the writing process
+		uint64_t                              pid          = 0;
+
+		/// \brief The (mangled) name of the dynamic type of the exception
+		::std::string                         type_name;
+
+		/// \brief The function from which the exception was thrown, or none if unknown
+		::boost::optional<::std::string>      function;
+
+		/// \brief The file from which the exception was thrown, or none if unknown
+		::boost::optional<::std::string>      file;
+
+		/// \brief The line from which the exception was thrown, or none if unknown
+		::boost::optional<detail::throw_line_value_t> line;
+
+		/// \brief The what() of the exception, or none if it isn't a std::exception
+		::boost::optional<::std::string>      what;
+
+		/// \brief The capture_policy that skipped the stacktrace capture, if it was skipped
+		::boost::optional<capture_policy>     capture_skipped_by;
+
+		/// \brief Whether the stacktrace was truncated by the capture_depth
+		bool                                  truncated    = false;
+
+		/// \brief The modules referenced by the frames
+		::std::vector<raw_trace_module>       modules;
+
+		/// \brief The frames, innermost first
+		::std::vector<raw_trace_frame>        frames;
+	};
+
+	namespace detail {
+
+		/// \brief The magic bytes at the start of each raw trace record
+		constexpr char raw_trace_magic[ 4 ] = { 'T', 'E', 'L', 'R' };
+
+		/// \brief The number of bytes in a raw trace record's header (the magic, the version and the payload length)
+		constexpr size_t raw_trace_header_size = sizeof( raw_trace_magic ) + 1 + 4;
+
+		/// \brief Whether the specified flags include the specified flag
+		inline bool has_raw_trace_flag(const uint64_t       &prm_flags, ///< The flags
+		                               const raw_trace_flag &prm_flag   ///< The flag to query
+		                               ) {
+			return ( prm_flags & static_cast<uint64_t>( prm_flag ) ) != 0;
+		}
+
+		/// \brief Write the specified string to the specified sink as a raw trace string (a ULEB128 length followed by the chars)
+		template <typename Sink>
+		void write_raw_trace_string(Sink               &prm_sink,     ///< The sink to which the string should be written
+		                            const char * const  prm_chars,    ///< The chars to write
+		                            const size_t       &prm_num_chars ///< The number of chars to write
+		                            ) {
+			write_uleb128( prm_sink, prm_num_chars );
+			prm_sink.write( prm_chars, prm_num_chars );
+		}
+
+		/// \brief Write the modules and frames sections of a raw trace payload for the specified frames to the specified sink
+		///
+		/// This locates each frame's module via the loaded_module_map but doesn't symbolize anything
+		template <typename Sink, typename Frames>
+		void write_raw_trace_frames(Sink         &prm_sink,  ///< The sink to which the sections should be written
+		                            const Frames &prm_frames ///< The frames to write (a boost::stacktrace::stacktrace or raw_frames_t)
+		                            ) {
+			auto &module_map = loaded_module_map::instance();
+
+			// Keep a copy of the snapshot so that its modules stay valid until they've been written
+			loaded_module_snapshot_cptr the_snapshot = module_map.snapshot();
+
+			// The modules and the frames' (module number, offset) pairs (of which there are typically only a handful and a few dozen)
+			::std::vector<const loaded_module_info *>    modules;
+			::std::vector<::std::pair<size_t, uint64_t>> frames;
+			bool                                         complete = false;
+			while ( ! complete ) {
+				modules.clear();
+				frames.clear();
+				complete = true;
+				for (const auto &frame : prm_frames) {
+					const auto         address    = reinterpret_cast<uintptr_t>( frame_address( frame ) );
+					const auto * const the_module = the_snapshot->find( address );
+					if ( the_module == nullptr ) {
+						// If the address is in a module loaded since the snapshot was taken, start again with the new snapshot
+						if ( module_map.find( address ) != nullptr ) {
+							the_snapshot = module_map.snapshot();
+							complete     = false;
+							break;
+						}
+						frames.emplace_back( 0, address );
+						continue;
+					}
+					size_t module_ctr = 0;
+					while ( module_ctr < modules.size() && modules[ module_ctr ] != the_module ) {
+						++module_ctr;
+					}
+					if ( module_ctr == modules.size() ) {
+						modules.push_back( the_module );
+					}
+					frames.emplace_back( module_ctr + 1, address - the_module->load_bias );
+				}
+			}
+
+			write_uleb128( prm_sink, modules.size() );
+			for (const auto &the_module : modules) {
+				write_raw_trace_string( prm_sink, the_module->build_id.data(), the_module->build_id.size() );
+				write_raw_trace_string( prm_sink, the_module->path.data(),     the_module->path.size()     );
+			}
+			write_uleb128( prm_sink, frames.size() );
+			for (const auto &the_frame : frames) {
+				write_uleb128( prm_sink, the_frame.first  );
+				write_uleb128( prm_sink, the_frame.second );
+			}
+		}
+
+		/// \brief Write the payload of a raw trace record for the specified exception to the specified sink
+		template <typename Sink, typename Ex>
+		void write_raw_trace_payload(Sink     &prm_sink,     ///< The sink to which the payload should be written
+		                             const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+		                             ) {
+			const auto * const function_value_ptr = ::boost::get_error_info< ::boost::throw_function >( prm_exception );
+			const auto * const file_value_ptr     = ::boost::get_error_info< ::boost::throw_file     >( prm_exception );
+			const auto * const line_value_ptr     = ::boost::get_error_info< ::boost::throw_line     >( prm_exception );
+			const char * const what_ptr           = get_what_ptr_of_std_exception( prm_exception );
+			const char * const type_name          = typeid( prm_exception ).name();
+
+			bool     capture_skipped    = false;
+			uint64_t packed_skip_policy = 0;
+			bool     truncated          = false;
+			visit_throw_record(
+				prm_exception,
+				[&] (const auto &x) {
+					if ( x.get_capture_skipped_by() ) {
+						capture_skipped    = true;
+						packed_skip_policy = x.get_capture_skipped_by()->pack();
+					}
+					truncated = static_cast<bool>( x.get_truncation() );
+				}
+			);
+
+			uint64_t flags = 0;
+			const auto add_flag_if = [&] (const bool &x, const raw_trace_flag &y) {
+				if ( x ) {
+					flags |= static_cast<uint64_t>( y );
+				}
+			};
+			add_flag_if( function_value_ptr != nullptr, raw_trace_flag::HAS_FUNCTION    );
+			add_flag_if( file_value_ptr     != nullptr, raw_trace_flag::HAS_FILE        );
+			add_flag_if( line_value_ptr     != nullptr, raw_trace_flag::HAS_LINE        );
+			add_flag_if( what_ptr           != nullptr, raw_trace_flag::HAS_WHAT        );
+			add_flag_if( capture_skipped,               raw_trace_flag::CAPTURE_SKIPPED );
+			add_flag_if( truncated,                     raw_trace_flag::TRUNCATED       );
+
+			write_uleb128( prm_sink, static_cast<uint64_t>( ::std::chrono::duration_cast<::std::chrono::nanoseconds>(
+				::std::chrono::system_clock::now().time_since_epoch()
+			).count() ) );
+			write_uleb128( prm_sink, static_cast<uint64_t>( ::getpid() ) );
+			write_uleb128( prm_sink, flags );
+			write_raw_trace_string( prm_sink, type_name, ::std::strlen( type_name ) );
+			if ( function_value_ptr != nullptr ) {
+				write_raw_trace_string( prm_sink, *function_value_ptr, ::std::strlen( *function_value_ptr ) );
+			}
+			if ( file_value_ptr != nullptr ) {
+				write_raw_trace_string( prm_sink, *file_value_ptr, ::std::strlen( *file_value_ptr ) );
+			}
+			if ( line_value_ptr != nullptr ) {
+				write_uleb128( prm_sink, static_cast<uint64_t>( *line_value_ptr ) );
+			}
+			if ( what_ptr != nullptr ) {
+				write_raw_trace_string( prm_sink, what_ptr, ::std::strlen( what_ptr ) );
+			}
+			if ( capture_skipped ) {
+				write_uleb128( prm_sink, packed_skip_policy );
+			}
+
+			const bool were_captured = visit_captured_frames(
+				prm_exception,
+				[&] (const auto &x) { write_raw_trace_frames( prm_sink, x ); }
+			);
+			if ( ! were_captured ) {
+				write_uleb128( prm_sink, 0 );
+				write_uleb128( prm_sink, 0 );
+			}
+		}
+
+		/// \brief Read a raw trace string with the specified reader
+		inline ::std::string read_raw_trace_string(byte_reader &prm_reader ///< The reader from which to read the string
+		                                           ) {
+			const size_t       length = static_cast<size_t>( prm_reader.read_uleb128() );
+			const byte_reader  chars  = prm_reader.sub_reader( length );
+			return { reinterpret_cast<const char *>( chars.position() ), chars.remaining() };
+		}
+
+	} // namespace detail
+
+	/// \brief Write a raw trace record for the specified boost::exception (as thrown by TELL_THROW()) to the specified sink
+	///
+	/// The sink may be a std::ostream or any of the sinks in output_sinks.hpp. See the file documentation for the format.
+	///
+	/// This doesn't symbolize anything.
+	template <typename Sink, typename Ex>
+	void write_exception_info_raw_trace(Sink     &&prm_sink,     ///< The sink to which the record should be written
+	                                    const Ex  &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+	                                    ) {
+		static_assert( ::std::is_base_of<::boost::exception, detail::remove_cvref_t<Ex>>::value,
+			"tell can only write_exception_info_raw_trace() when passed with a static type derived from boost::exception (or boost::exception itself)" );
+
+		// The payload's length goes before it, so build the payload first
+		::std::string payload;
+		string_sink   payload_sink{ payload };
+		detail::write_raw_trace_payload( payload_sink, prm_exception );
+
+		const auto length = static_cast<uint32_t>( payload.size() );
+		const char header[ detail::raw_trace_header_size ] = {
+			detail::raw_trace_magic[ 0 ],
+			detail::raw_trace_magic[ 1 ],
+			detail::raw_trace_magic[ 2 ],
+			detail::raw_trace_magic[ 3 ],
+			static_cast<char>( raw_trace_format_version ),
+			static_cast<char>(   length         & 0xFFu ),
+			static_cast<char>( ( length >>  8 ) & 0xFFu ),
+			static_cast<char>( ( length >> 16 ) & 0xFFu ),
+			static_cast<char>( ( length >> 24 ) & 0xFFu )
+		};
+		auto &&sink = detail::as_sink( prm_sink );
+		sink.write( header,         sizeof( header ) );
+		sink.write( payload.data(), payload.size()   );
+	}
+
+	/// \brief An append-only raw trace file, to which records of exceptions can be written
+	///
+	/// The file is opened with O_APPEND and each record is written with a single write(2), so several
+	/// threads (or processes) can write to the same file without their records interleaving.
+	///
+	/// This doesn't throw: it's used whilst handling an error so it shouldn't throw another.
+	class raw_trace_writer final {
+	private:
+		/// \brief The file descriptor of the file, or -1 if it couldn't be opened
+		int fd = -1;
+
+	public:
+		/// \brief Ctor from the path of the file, which is created if it doesn't exist
+		explicit raw_trace_writer(const ::std::string &prm_path ///< The path of the file
+		                          ) noexcept : fd{ ::open( prm_path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644 ) } {
+		}
+
+		~raw_trace_writer() noexcept {
+			if ( fd >= 0 ) {
+				::close( fd );
+			}
+		}
+
+		raw_trace_writer(const raw_trace_writer &) = delete;
+		raw_trace_writer(raw_trace_writer &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
+		raw_trace_writer & operator=(const raw_trace_writer &) = delete;
+		raw_trace_writer & operator=(raw_trace_writer &&) noexcept = delete; ///< Put in to appease clang-tidy's hicpp-special-member-functions check
+
+		/// \brief Whether the file was opened successfully
+		bool is_open() const noexcept {
+			return ( fd >= 0 );
+		}
+
+		/// \brief Write a raw trace record for the specified boost::exception (as thrown by TELL_THROW()) to the file
+		///
+		/// \returns Whether the record was made and written in full
+		template <typename Ex>
+		bool write(const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+		           ) noexcept {
+			if ( fd < 0 ) {
+				return false;
+			}
+			try {
+				::std::string record;
+				write_exception_info_raw_trace( string_sink{ record }, prm_exception );
+				return detail::write_fully( fd, record.data(), record.size() );
+			}
+			catch (...) {
+				return false;
+			}
+		}
+	};
+
+	/// \brief A reader of the raw trace records in a region of bytes (such as a mapped raw trace file)
+	class raw_trace_reader final {
+	private:
+		/// \brief The reader of the remaining bytes
+		detail::byte_reader reader;
+
+		/// \brief Whether a malformed or incomplete record has been found
+		bool failed = false;
+
+	public:
+		/// \brief Ctor from the region of bytes to read
+		raw_trace_reader(const unsigned char * const prm_begin,     ///< The start of the region
+		                 const size_t                &prm_num_bytes ///< The number of bytes in the region
+		                 ) noexcept : reader{ prm_begin, prm_num_bytes } {
+		}
+
+		/// \brief Read the next record into the specified record
+		///
+		/// \returns Whether a record was read (rather than the end being reached or a malformed or incomplete record being found)
+		bool next(raw_trace_record &prm_record ///< The record into which the next record should be read
+		          ) {
+			if ( failed || reader.at_end() ) {
+				return false;
+			}
+
+			const detail::byte_reader record_start = reader;
+			detail::byte_reader       header       = reader.sub_reader( detail::raw_trace_header_size );
+			const auto magic   = header.read<::std::array<char, sizeof( detail::raw_trace_magic )>>();
+			const auto version = header.read<uint8_t>();
+			uint32_t   length  = 0;
+			for (size_t byte_ctr = 0; byte_ctr < 4; ++byte_ctr) {
+				length |= ( static_cast<uint32_t>( header.read<uint8_t>() ) << ( 8 * byte_ctr ) );
+			}
+			if ( ! header.ok()
+					|| ::std::memcmp( magic.data(), detail::raw_trace_magic, sizeof( detail::raw_trace_magic ) ) != 0
+					|| version != raw_trace_format_version ) {
+				reader = record_start;
+				failed = true;
+				return false;
+			}
+			detail::byte_reader payload = reader.sub_reader( length );
+
+			raw_trace_record record;
+			record.timestamp_ns = payload.read_uleb128();
+			record.pid          = payload.read_uleb128();
+			const uint64_t flags = payload.read_uleb128();
+			record.type_name    = detail::read_raw_trace_string( payload );
+			if ( detail::has_raw_trace_flag( flags, raw_trace_flag::HAS_FUNCTION ) ) {
+				record.function = detail::read_raw_trace_string( payload );
+			}
+			if ( detail::has_raw_trace_flag( flags, raw_trace_flag::HAS_FILE ) ) {
+				record.file = detail::read_raw_trace_string( payload );
+			}
+			if ( detail::has_raw_trace_flag( flags, raw_trace_flag::HAS_LINE ) ) {
+				record.line = static_cast<detail::throw_line_value_t>( payload.read_uleb128() );
+			}
+			if ( detail::has_raw_trace_flag( flags, raw_trace_flag::HAS_WHAT ) ) {
+				record.what = detail::read_raw_trace_string( payload );
+			}
+			if ( detail::has_raw_trace_flag( flags, raw_trace_flag::CAPTURE_SKIPPED ) ) {
+				record.capture_skipped_by = capture_policy::unpack( payload.read_uleb128() );
+			}
+			record.truncated = detail::has_raw_trace_flag( flags, raw_trace_flag::TRUNCATED );
+
+			const uint64_t num_modules = payload.read_uleb128();
+			for (uint64_t module_ctr = 0; module_ctr < num_modules && payload.ok(); ++module_ctr) {
+				raw_trace_module the_module;
+				the_module.build_id = detail::read_raw_trace_string( payload );
+				the_module.path     = detail::read_raw_trace_string( payload );
+				record.modules.push_back( ::std::move( the_module ) );
+			}
+			const uint64_t num_frames = payload.read_uleb128();
+			for (uint64_t frame_ctr = 0; frame_ctr < num_frames && payload.ok(); ++frame_ctr) {
+				const uint64_t  module_number = payload.read_uleb128();
+				raw_trace_frame the_frame;
+				the_frame.offset = payload.read_uleb128();
+				if ( module_number != 0 && module_number <= record.modules.size() ) {
+					the_frame.module_index = static_cast<size_t>( module_number - 1 );
+				}
+				record.frames.push_back( the_frame );
+			}
+
+			if ( ! reader.ok() || ! payload.ok() ) {
+				reader = record_start;
+				failed = true;
+				return false;
+			}
+			prm_record = ::std::move( record );
+			return true;
+		}
+
+		/// \brief Whether all the records read were well-formed and complete
+		///
+		/// A file that's being appended to when it's read (or whose writer crashed mid-write)
+		/// may end with an incomplete record, which makes this false
+		bool ok() const noexcept {
+			return ! failed;
+		}
+
+		/// \brief The number of bytes that haven't been read as records (including any malformed or incomplete record)
+		size_t remaining() const noexcept {
+			return reader.remaining();
+		}
+	};
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_RAW_TRACE_FILE_HPP
@@ -3,12 +3,24 @@
 
 #include <string>
 #include <type_traits>
+#include <typeinfo>
 
+#include <boost/core/demangle.hpp>
 #include <boost/exception/get_error_info.hpp>
 #include <boost/optional.hpp>
 
+#include "tell/capture_policy.hpp"
+#include "tell/detail/captured_frames.hpp"
+#include "tell/detail/sink_formatting.hpp"
+#include "tell/detail/throw_record.hpp"
+#include "tell/detail/type_name_cache.hpp"
 #include "tell/detail/types.hpp"
+#include "tell/frame_prefix_matcher.hpp"
+#include "tell/instrumentation.hpp"
+#include "tell/output_sinks.hpp"
+#include "tell/stack_fingerprint.hpp"
 #include "tell/stacktrace_to_cleaned_string.hpp"
+#include "tell/trace_registry.hpp"
 
 namespace tell { namespace except {
 
@@ -43,22 +55,32 @@ namespace tell { namespace except {
 			return {};
 		}
 
-		/// \brief Tag-dispatch overload for getting the what() of a type that isn't a std::exception, so just return none
+		/// \brief Tag-dispatch overload for getting the what() of a type that isn't a std::exception, so just return nullptr
 		template <typename Ex>
-		inline ::boost::optional<::std::string> get_what_of_std_exception_impl(const ::std::false_type &/* inherits_from_std_exception_tag */, ///< Type to indicate that std::exception *is not* a base of Ex
-		                                                                       const Ex                &prm_value                              ///< The object of some type not derived from ::std::exception
-		                                                                       ) {
+		inline const char * get_what_ptr_of_std_exception_impl(const ::std::false_type &/* inherits_from_std_exception_tag */, ///< Type to indicate that std::exception *is not* a base of Ex
+		                                                       const Ex                &prm_value                              ///< The object of some type not derived from ::std::exception
+		                                                       ) {
 			const auto std_except_ptr = dynamic_cast<const ::std::exception *>( &prm_value );
 			return ( std_except_ptr != nullptr )
-				? ::boost::make_optional( ::std::string{ std_except_ptr->what() } )
-				: ::boost::none;
+				? std_except_ptr->what()
+				: nullptr;
 		}
 
-		/// \brief Tag-dispatch overload for getting the what() of a std::exception, so do that 
-		inline ::boost::optional<::std::string> get_what_of_std_exception_impl(const ::std::true_type &/* inherits_from_std_exception_tag */, ///< Type to indicate that std::exception *is* a base of Ex
-		                                                                       const std::exception   &prm_value                              ///< The object of some type derived from ::std::exception
-		                                                                       ) {
-			return ::std::string{ prm_value.what() };
+		/// \brief Tag-dispatch overload for getting the what() of a std::exception, so do that
+		inline const char * get_what_ptr_of_std_exception_impl(const ::std::true_type &/* inherits_from_std_exception_tag */, ///< Type to indicate that std::exception *is* a base of Ex
+		                                                       const std::exception   &prm_value                              ///< The object of some type derived from ::std::exception
+		                                                       ) {
+			return prm_value.what();
+		}
+
+		/// \brief Return the what() from the specified value if it's of a type derived from std::exception, or nullptr otherwise
+		///
+		/// More specifically if std::exception is a base of the argument's static type, this calls what() directly
+		/// otherwise, it attempts to dynamic_cast to a std::exception and then call what() on the result if successful
+		template <typename Ex>
+		inline const char * get_what_ptr_of_std_exception(const Ex &prm_value ///< The value to query
+		                                                  ) {
+			return get_what_ptr_of_std_exception_impl( tag_value_for_is_base_of_arg< ::std::exception >( prm_value ), prm_value );
 		}
 
 		/// \brief Return the what() from the specified value if it's of a type derived from std::exception, or none otherwise
@@ -68,56 +90,274 @@ namespace tell { namespace except {
 		template <typename Ex>
 		inline ::boost::optional<::std::string> get_what_of_std_exception(const Ex &prm_value ///< The value to query
 		                                                                  ) {
-			return get_what_of_std_exception_impl( tag_value_for_is_base_of_arg< ::std::exception >( prm_value ), prm_value );
+			const char * const what_ptr = get_what_ptr_of_std_exception( prm_value );
+			return ( what_ptr != nullptr )
+				? ::boost::make_optional( ::std::string{ what_ptr } )
+				: ::boost::none;
+		}
+
+		/// \brief Write a description of a thrown exception and where it was thrown (without any stacktrace),
+		///        given the demangled name of its dynamic type, to the specified sink
+		///
+		/// Any of the pointers may be nullptr if that information isn't known
+		template <typename Sink>
+		void write_demangled_thrown_exception_description(Sink                     &prm_sink,              ///< The sink to which the description should be written
+		                                                  const char               *prm_dynamic_type_name, ///< The (demangled) name of the dynamic type of the exception
+		                                                  const char               *prm_function,          ///< The name of the function containing the code that threw
+		                                                  const char               *prm_file,              ///< The name of the source file containing the code that threw
+		                                                  const throw_line_value_t *prm_line_ptr,          ///< The number of the source line containing the code that threw
+		                                                  const char               *prm_what               ///< The what() of the exception
+		                                                  ) {
+			write_cstring( prm_sink, "Retrieving "           );
+			write_cstring( prm_sink, prm_dynamic_type_name   );
+			write_cstring( prm_sink, " that had been thrown" );
+			if ( prm_function != nullptr ) {
+				write_cstring( prm_sink, " in '"       );
+				write_cstring( prm_sink, prm_function );
+				write_cstring( prm_sink, "'"           );
+			}
+			if ( prm_file != nullptr && prm_line_ptr != nullptr ) {
+				write_cstring( prm_sink, " at "        );
+				write_cstring( prm_sink, prm_file      );
+				write_cstring( prm_sink, ":"           );
+				write_decimal( prm_sink, *prm_line_ptr );
+			}
+			if ( prm_what != nullptr ) {
+				write_cstring( prm_sink, " with message '" );
+				write_cstring( prm_sink, prm_what          );
+				write_cstring( prm_sink, "'"               );
+			}
+		}
+
+		/// \brief Write a description of a thrown exception and where it was thrown (without any stacktrace) to the specified sink
+		///
+		/// This is for when only the mangled name of the exception's type is available (eg when it's been read from a
+		/// file); otherwise, prefer the overload that takes the std::type_info, which demangles via the type_name_cache.
+		///
+		/// Any of the pointers may be nullptr if that information isn't known
+		template <typename Sink>
+		void write_thrown_exception_description(Sink                     &prm_sink,      ///< The sink to which the description should be written
+		                                        const char               *prm_type_name, ///< The (mangled) name of the dynamic type of the exception, as from typeid().name()
+		                                        const char               *prm_function,  ///< The name of the function containing the code that threw
+		                                        const char               *prm_file,      ///< The name of the source file containing the code that threw
+		                                        const throw_line_value_t *prm_line_ptr,  ///< The number of the source line containing the code that threw
+		                                        const char               *prm_what       ///< The what() of the exception
+		                                        ) {
+			const ::boost::core::scoped_demangled_name demangled_name{ prm_type_name };
+			const char * const dynamic_type_name = ( demangled_name.get() != nullptr ) ? demangled_name.get() : prm_type_name;
+			write_demangled_thrown_exception_description( prm_sink, dynamic_type_name, prm_function, prm_file, prm_line_ptr, prm_what );
+		}
+
+		/// \brief Write a description of a thrown exception and where it was thrown (without any stacktrace) to the specified sink
+		///
+		/// Any of the pointers may be nullptr if that information isn't known
+		template <typename Sink>
+		void write_thrown_exception_description(Sink                     &prm_sink,     ///< The sink to which the description should be written
+		                                        const ::std::type_info   &prm_type,     ///< The dynamic type of the exception
+		                                        const char               *prm_function, ///< The name of the function containing the code that threw
+		                                        const char               *prm_file,     ///< The name of the source file containing the code that threw
+		                                        const throw_line_value_t *prm_line_ptr, ///< The number of the source line containing the code that threw
+		                                        const char               *prm_what      ///< The what() of the exception
+		                                        ) {
+			write_demangled_thrown_exception_description( prm_sink, demangled_type_name( prm_type ).c_str(), prm_function, prm_file, prm_line_ptr, prm_what );
+		}
+
+		/// \brief Write a description of the specified exception and where it was thrown (without any stacktrace) to the specified sink
+		template <typename Sink, typename Ex>
+		void write_thrown_exception(Sink     &prm_sink,     ///< The sink to which the description should be written
+		                            const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+		                            ) {
+			const auto * const file_value_ptr     = ::boost::get_error_info< ::boost::throw_file     >( prm_exception );
+			const auto * const function_value_ptr = ::boost::get_error_info< ::boost::throw_function >( prm_exception );
+			write_thrown_exception_description(
+				prm_sink,
+				typeid( prm_exception ),
+				( function_value_ptr != nullptr ) ? *function_value_ptr : nullptr,
+				( file_value_ptr     != nullptr ) ? *file_value_ptr     : nullptr,
+				::boost::get_error_info< ::boost::throw_line >( prm_exception ),
+				get_what_ptr_of_std_exception( prm_exception )
+			);
+		}
+
+		/// \brief Write the heading for a stacktrace (including the fingerprint to mark its first sight, if specified) to the specified sink
+		template <typename Sink>
+		void write_stacktrace_heading(Sink                                         &prm_sink,       ///< The sink to which the heading should be written
+		                              const ::boost::optional<stack_fingerprint_t> &prm_fingerprint ///< The fingerprint to put in the heading to mark the first sight of the stacktrace, or none
+		                              ) {
+			write_cstring( prm_sink, "\nStacktrace" );
+			if ( prm_fingerprint ) {
+				write_cstring( prm_sink, " (fingerprint " );
+				write_hex    ( prm_sink, *prm_fingerprint );
+				write_cstring( prm_sink, ", first seen)"  );
+			}
+		}
+
+		/// \brief Write a stacktrace section describing the specified captured frames to the specified sink
+		template <typename Sink, typename Frames>
+		void write_captured_frames(Sink                                         &prm_sink,                        ///< The sink to which the description should be written
+		                           const Frames                                 &prm_frames,                      ///< The frames to describe (a boost::stacktrace::stacktrace or raw_frames_t)
+		                           const ::boost::optional<size_t>              &prm_truncation  = ::boost::none, ///< The number of frames kept if the capture was truncated, or none
+		                           const ::boost::optional<stack_fingerprint_t> &prm_fingerprint = ::boost::none  ///< The fingerprint to put in the heading to mark the first sight of the stacktrace, or none
+		                           ) {
+			write_stacktrace_heading ( prm_sink, prm_fingerprint );
+			write_cstring            ( prm_sink, ":\n"           );
+			write_stripped_by_matcher( prm_sink, prm_frames, frame_prefix_matcher{} );
+			if ( prm_truncation ) {
+				write_truncation_marker( prm_sink, *prm_truncation );
+			}
+		}
+
+		/// \brief Write a stacktrace section explaining that the capture was skipped by the specified capture_policy to the specified sink
+		template <typename Sink>
+		void write_capture_skipped(Sink                                         &prm_sink,                       ///< The sink to which the description should be written
+		                           const capture_policy                         &prm_policy,                     ///< The capture_policy that skipped the capture
+		                           const ::boost::optional<stack_fingerprint_t> &prm_fingerprint = ::boost::none ///< The fingerprint to put in the heading to mark the first sight of the stacktrace, or none
+		                           ) {
+			write_stacktrace_heading( prm_sink, prm_fingerprint );
+			write_cstring( prm_sink, ": not captured (skipped by capture policy: " );
+			write_string ( prm_sink, to_string( prm_policy )                       );
+			write_cstring( prm_sink, ")\n"                                         );
+		}
+
+		/// \brief Write a description of the frames in the specified throw_record (or of why they weren't captured) to the specified sink
+		template <typename Sink, typename Frames>
+		void write_throw_record_stacktrace(Sink                                         &prm_sink,                       ///< The sink to which the description should be written
+		                                   const throw_record<Frames>                   &prm_record,                     ///< The throw_record that TELL_THROW() attached
+		                                   const ::boost::optional<stack_fingerprint_t> &prm_fingerprint = ::boost::none ///< The fingerprint to put in the heading to mark the first sight of the stacktrace, or none
+		                                   ) {
+			if ( const auto * const frames_ptr = prm_record.get_frames() ) {
+				write_captured_frames( prm_sink, *frames_ptr, prm_record.get_truncation(), prm_fingerprint );
+			}
+			else if ( prm_record.get_capture_skipped_by() ) {
+				write_capture_skipped( prm_sink, *prm_record.get_capture_skipped_by(), prm_fingerprint );
+			}
+		}
+
+		/// \brief Write a description of the frames that TELL_THROW() captured in the specified exception (or of why
+		///        they weren't captured, or nothing if neither is known) to the specified sink
+		template <typename Sink, typename Ex>
+		void write_captured_stacktrace(Sink                                         &prm_sink,                       ///< The sink to which the description should be written
+		                               const Ex                                     &prm_exception,                  ///< The boost::exception, hopefully thrown via TELL_THROW
+		                               const ::boost::optional<stack_fingerprint_t> &prm_fingerprint = ::boost::none ///< The fingerprint to put in the heading to mark the first sight of the stacktrace, or none
+		                               ) {
+			visit_throw_record(
+				prm_exception,
+				[&] (const auto &x) { write_throw_record_stacktrace( prm_sink, x, prm_fingerprint ); }
+			);
+		}
+
+		/// \brief Write a description of the frames that TELL_THROW() captured in the specified exception (as
+		///        write_captured_stacktrace()) to the specified sink, rendering it only on the first call for
+		///        the exception and memoizing it in its throw_record
+		///
+		/// The same caught exception is often described several times (eg by a logger, an error reporter and a metrics
+		/// tagger), so this saves re-symbolizing on each. Only the stacktrace is memoized because the rest of the
+		/// description can change (see throw_record).
+		template <typename Sink, typename Ex>
+		void write_memoized_captured_stacktrace(Sink     &prm_sink,     ///< The sink to which the description should be written
+		                                        const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+		                                        ) {
+			visit_throw_record(
+				prm_exception,
+				[&] (const auto &x) {
+					if ( const ::std::string * const rendered_ptr = x.get_rendered_stacktrace() ) {
+						write_string( prm_sink, *rendered_ptr );
+						return;
+					}
+					::std::string rendered;
+					string_sink   rendered_sink{ rendered };
+					write_throw_record_stacktrace( rendered_sink, x );
+					write_string( prm_sink, x.set_rendered_stacktrace( ::std::move( rendered ) ) );
+				}
+			);
+		}
+
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+
+		/// \brief Record a render of the specified exception that started at the specified time, against the site that threw it
+		template <typename Ex>
+		void record_render_of(const Ex                                &prm_exception, ///< The boost::exception that has been rendered
+		                      const instrumentation_clock::time_point &prm_start      ///< The time at which the render started
+		                      ) {
+			const uint64_t     render_ns      = nanoseconds_since( prm_start );
+			const auto * const file_value_ptr = ::boost::get_error_info< ::boost::throw_file >( prm_exception );
+			const auto * const line_value_ptr = ::boost::get_error_info< ::boost::throw_line >( prm_exception );
+			record_render(
+				( file_value_ptr != nullptr ) ? *file_value_ptr : nullptr,
+				( line_value_ptr != nullptr ) ? *line_value_ptr : 0,
+				render_ns
+			);
+		}
+
+#endif
+
+		/// \brief Write a description of where exception info is being retrieved to the specified sink
+		template <typename Sink>
+		void write_retrieval_context(Sink                         &prm_sink,     ///< The sink to which the description should be written
+		                             const throw_function_value_t &prm_function, ///< The name of the function containing the code that wants to retrieve this information
+		                             const throw_file_value_t     &prm_file,     ///< The name of the source file containing the code that wants to retrieve this information
+		                             const throw_line_value_t     &prm_line      ///< The number of the source line containing the code that wants to retrieve this information
+		                             ) {
+			write_cstring( prm_sink, "In '"       );
+			write_cstring( prm_sink, prm_function );
+			write_cstring( prm_sink, "' at "      );
+			write_cstring( prm_sink, prm_file     );
+			write_cstring( prm_sink, ":"          );
+			write_decimal( prm_sink, prm_line     );
+			write_cstring( prm_sink, " : "        );
 		}
 
 	} // namespace detail
 
+	/// \brief Write a description of the specified boost::exception, retrieving info added by TELL_THROW(), to the specified sink
+	///
+	/// The sink may be a std::ostream or any of the sinks in output_sinks.hpp
+	///
+	/// The stacktrace of an exception thrown via TELL_THROW() is rendered on the first call and memoized in the exception,
+	/// so later calls for the same exception (or a copy of it) only re-render its throw location, type and what()
+	///
+	/// If TELL_ENABLE_INSTRUMENTATION is defined, the render's cost is recorded against the site that threw the exception
+	template <typename Sink, typename Ex>
+	void write_exception_info(Sink     &&prm_sink,     ///< The sink to which the description should be written
+	                          const Ex  &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+	                          ) {
+		static_assert( ::std::is_base_of<::boost::exception, detail::remove_cvref_t<Ex>>::value,
+			"tell can only write_exception_info() when passed with a static type derived from boost::exception (or boost::exception itself)" );
+
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+		const auto render_start = detail::instrumentation_clock::now();
+#endif
+		auto &&sink = detail::as_sink( prm_sink );
+		detail::write_thrown_exception            ( sink, prm_exception );
+		detail::write_memoized_captured_stacktrace( sink, prm_exception );
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+		detail::record_render_of( prm_exception, render_start );
+#endif
+	}
+
+	/// \brief Write a description of the specified boost::exception, retrieving info added by TELL_THROW(),
+	///        including context information about where the information is being retrieved, to the specified sink
+	///
+	/// Don't use this function directly, use the macro TELL_WRITE_EXCEPTION_INFO()
+	template <typename Sink, typename Ex>
+	void write_exception_info(Sink                                 &&prm_sink,      ///< The sink to which the description should be written
+	                          const Ex                              &prm_exception, ///< The boost::exception, hopefully thrown via TELL_THROW
+	                          const detail::throw_function_value_t  &prm_function,  ///< The name of the function containing the code that wants to retrieve this information
+	                          const detail::throw_file_value_t      &prm_file,      ///< The name of the source file containing the code that wants to retrieve this information
+	                          const detail::throw_line_value_t      &prm_line       ///< The number of the source line containing the code that wants to retrieve this information
+	                          ) {
+		auto &&sink = detail::as_sink( prm_sink );
+		detail::write_retrieval_context( sink, prm_function, prm_file, prm_line );
+		write_exception_info( sink, prm_exception );
+	}
+
 	/// \brief Generate a string describing the specified boost::exception, retrieving info added by TELL_THROW()
 	template <typename Ex>
 	inline std::string retrieve_exception_info(const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
 	                                           ) {
-		static_assert( ::std::is_base_of<::boost::exception, detail::remove_cvref_t<Ex>>::value,
-			"tell can only retrieve_exception_info() when passed with a static type derived from boost::exception (or boost::exception itself)" );
-
-		const auto &file_value_ptr     = ::boost::get_error_info< ::boost::throw_file                           >( prm_exception );
-		const auto &line_value_ptr     = ::boost::get_error_info< ::boost::throw_line                           >( prm_exception );
-		const auto &function_value_ptr = ::boost::get_error_info< ::boost::throw_function                       >( prm_exception );
-		const auto &stacktrace_ptr     = ::boost::get_error_info< detail::boost_exception_stacktrace_error_info >( prm_exception );
-		const auto &what_msg           = detail::get_what_of_std_exception( prm_exception );
-		const auto &dynamic_type_name  = ::boost::core::demangle( typeid( prm_exception ).name() );
-
-		const auto prefixes_to_remove  = { "void tell::except::detail::throw_with_locn_and_stacktrace" };
-
-		return "Retrieving "
-			+ dynamic_type_name
-			+ " that had been thrown"
-			+ (
-				( function_value_ptr != nullptr )
-				? ( " in '" + ::std::string{ *function_value_ptr } + "'" )
-				: ""
-			)
-			+ (
-				( file_value_ptr != nullptr && line_value_ptr != nullptr )
-				? " at "
-					+ ::std::string   { *file_value_ptr     }
-					+ ":"
-					+ ::std::to_string( *line_value_ptr     )
-				: ""
-			)
-			+ (
-				what_msg
-				? ( " with message '" + *what_msg + "'" )
-				: ""
-			)
-			+ (
-				( stacktrace_ptr != nullptr )
-				? "\nStacktrace:\n" + detail::to_string_stripped_by_prefixes(
-					*stacktrace_ptr,
-					prefixes_to_remove
-				)
-				: ""
-			);
+		::std::string result;
+		write_exception_info( string_sink{ result }, prm_exception );
+		return result;
 	}
 
 	/// \brief Generate a string describing the specified boost::exception, retrieving info added by TELL_THROW()
@@ -130,14 +370,96 @@ namespace tell { namespace except {
 	                                           const detail::throw_file_value_t     &prm_file,      ///< The name of the source file containing the code that wants to retrieve this information
 	                                           const detail::throw_line_value_t     &prm_line       ///< The number of the source line containing the code that wants to retrieve this information
 	                                           ) {
-		return "In '"
-			+ ::std::string   ( prm_function )
-			+ "' at "
-			+ ::std::string   ( prm_file     )
-			+ ":"
-			+ ::std::to_string( prm_line     )
-			+ " : "
-			+ retrieve_exception_info( prm_exception );
+		::std::string result;
+		write_exception_info( string_sink{ result }, prm_exception, prm_function, prm_file, prm_line );
+		return result;
+	}
+
+	/// \brief Write a description of the specified boost::exception, retrieving info added by TELL_THROW(), to the
+	///        specified sink but only rendering the stacktrace in full the first time its fingerprint is seen
+	///
+	/// The occurrence is recorded in the specified trace_registry (by default, the process-wide one).
+	/// On subsequent sightings of the same stacktrace, this just gives its fingerprint and the number
+	/// of times it's been seen, which avoids the cost of symbolizing and shipping the same text repeatedly.
+	template <typename Sink, typename Ex>
+	void write_exception_info_deduplicated(Sink           &&prm_sink,                                 ///< The sink to which the description should be written
+	                                       const Ex        &prm_exception,                            ///< The boost::exception, hopefully thrown via TELL_THROW
+	                                       trace_registry  &prm_registry = trace_registry::instance() ///< The registry in which to record the stacktrace's fingerprint
+	                                       ) {
+		static_assert( ::std::is_base_of<::boost::exception, detail::remove_cvref_t<Ex>>::value,
+			"tell can only write_exception_info_deduplicated() when passed with a static type derived from boost::exception (or boost::exception itself)" );
+
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+		const auto render_start = detail::instrumentation_clock::now();
+#endif
+		auto &&sink = detail::as_sink( prm_sink );
+		detail::write_thrown_exception( sink, prm_exception );
+
+		const auto fingerprint   = get_stack_fingerprint( prm_exception );
+		const auto num_sightings = fingerprint ? prm_registry.record( *fingerprint ) : 0;
+		if ( num_sightings > 1 ) {
+			detail::write_cstring( sink, "\nStacktrace: fingerprint "          );
+			detail::write_hex    ( sink, *fingerprint                          );
+			detail::write_cstring( sink, ", seen "                             );
+			detail::write_decimal( sink, static_cast<int64_t>( num_sightings ) );
+			detail::write_cstring( sink, " times\n"                            );
+		}
+		else {
+			detail::write_captured_stacktrace( sink, prm_exception, fingerprint );
+		}
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+		detail::record_render_of( prm_exception, render_start );
+#endif
+	}
+
+	/// \brief Write a description of the specified boost::exception, retrieving info added by TELL_THROW(), including
+	///        context information about where the information is being retrieved, to the specified sink but only
+	///        rendering the stacktrace in full the first time its fingerprint is seen
+	///
+	/// Don't use this function directly, use the macro TELL_WRITE_EXCEPTION_INFO_DEDUPLICATED()
+	/// (or TELL_WRITE_EXCEPTION_INFO_DEDUPLICATED_IN() to record in a registry other than the process-wide one)
+	template <typename Sink, typename Ex>
+	void write_exception_info_deduplicated(Sink                                 &&prm_sink,                                 ///< The sink to which the description should be written
+	                                       const Ex                              &prm_exception,                            ///< The boost::exception, hopefully thrown via TELL_THROW
+	                                       const detail::throw_function_value_t  &prm_function,                             ///< The name of the function containing the code that wants to retrieve this information
+	                                       const detail::throw_file_value_t      &prm_file,                                 ///< The name of the source file containing the code that wants to retrieve this information
+	                                       const detail::throw_line_value_t      &prm_line,                                 ///< The number of the source line containing the code that wants to retrieve this information
+	                                       trace_registry                        &prm_registry = trace_registry::instance() ///< The registry in which to record the stacktrace's fingerprint
+	                                       ) {
+		auto &&sink = detail::as_sink( prm_sink );
+		detail::write_retrieval_context( sink, prm_function, prm_file, prm_line );
+		write_exception_info_deduplicated( sink, prm_exception, prm_registry );
+	}
+
+	/// \brief Generate a string describing the specified boost::exception, retrieving info added by TELL_THROW()
+	///        but only rendering the stacktrace in full the first time its fingerprint is seen
+	///
+	/// See write_exception_info_deduplicated()
+	template <typename Ex>
+	inline std::string retrieve_exception_info_deduplicated(const Ex       &prm_exception,                            ///< The boost::exception, hopefully thrown via TELL_THROW
+	                                                        trace_registry &prm_registry = trace_registry::instance() ///< The registry in which to record the stacktrace's fingerprint
+	                                                        ) {
+		::std::string result;
+		write_exception_info_deduplicated( string_sink{ result }, prm_exception, prm_registry );
+		return result;
+	}
+
+	/// \brief Generate a string describing the specified boost::exception, retrieving info added by TELL_THROW()
+	///        including context information about where the information is being retrieved, but only rendering
+	///        the stacktrace in full the first time its fingerprint is seen
+	///
+	/// Don't use this function directly, use the macro TELL_RETRIEVE_EXCEPTION_INFO_DEDUPLICATED()
+	/// (or TELL_RETRIEVE_EXCEPTION_INFO_DEDUPLICATED_IN() to record in a registry other than the process-wide one)
+	template <typename Ex>
+	inline std::string retrieve_exception_info_deduplicated(const Ex                             &prm_exception,                            ///< The boost::exception, hopefully thrown via TELL_THROW
+	                                                        const detail::throw_function_value_t &prm_function,                             ///< The name of the function containing the code that wants to retrieve this information
+	                                                        const detail::throw_file_value_t     &prm_file,                                 ///< The name of the source file containing the code that wants to retrieve this information
+	                                                        const detail::throw_line_value_t     &prm_line,                                 ///< The number of the source line containing the code that wants to retrieve this information
+	                                                        trace_registry                       &prm_registry = trace_registry::instance() ///< The registry in which to record the stacktrace's fingerprint
+	                                                        ) {
+		::std::string result;
+		write_exception_info_deduplicated( string_sink{ result }, prm_exception, prm_function, prm_file, prm_line, prm_registry );
+		return result;
 	}
 
 } // namespace except
@@ -147,4 +469,24 @@ namespace tell { namespace except {
 ///        including context information about where the information is being retrieved
 #define TELL_RETRIEVE_EXCEPTION_INFO(x) ::tell::except::retrieve_exception_info( ((x)), BOOST_THROW_EXCEPTION_CURRENT_FUNCTION, __FILE__, __LINE__ )
 
+/// \brief Generate a string describing the specified boost::exception, retrieving info added by TELL_THROW()
+///        including context information about where the information is being retrieved, but only rendering
+///        the stacktrace in full the first time its fingerprint is seen
+#define TELL_RETRIEVE_EXCEPTION_INFO_DEDUPLICATED(x) ::tell::except::retrieve_exception_info_deduplicated( ((x)), BOOST_THROW_EXCEPTION_CURRENT_FUNCTION, __FILE__, __LINE__ )
+
+/// \brief As TELL_RETRIEVE_EXCEPTION_INFO_DEDUPLICATED() but recording the stacktrace's fingerprint in the specified trace_registry
+#define TELL_RETRIEVE_EXCEPTION_INFO_DEDUPLICATED_IN(x, r) ::tell::except::retrieve_exception_info_deduplicated( ((x)), BOOST_THROW_EXCEPTION_CURRENT_FUNCTION, __FILE__, __LINE__, ((r)) )
+
+/// \brief Write a description of the specified boost::exception, retrieving info added by TELL_THROW()
+///        including context information about where the information is being retrieved, to the specified sink
+#define TELL_WRITE_EXCEPTION_INFO(s, x) ::tell::except::write_exception_info( ((s)), ((x)), BOOST_THROW_EXCEPTION_CURRENT_FUNCTION, __FILE__, __LINE__ )
+
+/// \brief Write a description of the specified boost::exception, retrieving info added by TELL_THROW()
+///        including context information about where the information is being retrieved, to the specified sink
+///        but only rendering the stacktrace in full the first time its fingerprint is seen
+#define TELL_WRITE_EXCEPTION_INFO_DEDUPLICATED(s, x) ::tell::except::write_exception_info_deduplicated( ((s)), ((x)), BOOST_THROW_EXCEPTION_CURRENT_FUNCTION, __FILE__, __LINE__ )
+
+/// \brief As TELL_WRITE_EXCEPTION_INFO_DEDUPLICATED() but recording the stacktrace's fingerprint in the specified trace_registry
+#define TELL_WRITE_EXCEPTION_INFO_DEDUPLICATED_IN(s, x, r) ::tell::except::write_exception_info_deduplicated( ((s)), ((x)), BOOST_THROW_EXCEPTION_CURRENT_FUNCTION, __FILE__, __LINE__, ((r)) )
+
 #endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_RETRIEVE_EXCEPTION_INFO_HPP
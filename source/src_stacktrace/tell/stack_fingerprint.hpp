@@ -0,0 +1,75 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_STACK_FINGERPRINT_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_STACK_FINGERPRINT_HPP
+
+#include <cstdint>
+
+#include <boost/optional.hpp>
+
+#include "tell/detail/captured_frames.hpp"
+
+namespace tell { namespace except {
+
+	/// \brief Type alias for a fingerprint of a stacktrace
+	using stack_fingerprint_t = uint64_t;
+
+	namespace detail {
+
+		/// \brief The FNV-1a 64-bit offset basis
+		constexpr stack_fingerprint_t fnv1a_offset_basis = 0xCBF29CE484222325ULL;
+
+		/// \brief The FNV-1a 64-bit prime
+		constexpr stack_fingerprint_t fnv1a_prime        = 0x100000001B3ULL;
+
+		/// \brief Mix the bytes of the specified address into the specified FNV-1a hash
+		inline stack_fingerprint_t fnv1a_mix_address(stack_fingerprint_t  prm_hash,   ///< The hash so far
+		                                             const void * const   prm_address ///< The address to mix in
+		                                             ) noexcept {
+			uintptr_t value = reinterpret_cast<uintptr_t>( prm_address );
+			for (size_t byte_ctr = 0; byte_ctr < sizeof( value ); ++byte_ctr) {
+				prm_hash ^= static_cast<stack_fingerprint_t>( value & 0xFFu );
+				prm_hash *= fnv1a_prime;
+				value >>= 8;
+			}
+			return prm_hash;
+		}
+
+		/// \brief Compute the fingerprint of the specified frames
+		///
+		/// This just hashes the addresses. tell's own throw frames aren't captured (see attach_locn_and_stacktrace())
+		/// so this needn't symbolize anything to skip them. The frames of a given trace in a given process always
+		/// give the same fingerprint but fingerprints aren't comparable across processes (because of ASLR).
+		template <typename Frames>
+		stack_fingerprint_t fingerprint_frames(const Frames &prm_frames ///< The frames (a boost::stacktrace::stacktrace or raw_frames_t)
+		                                       ) noexcept {
+			stack_fingerprint_t hash = fnv1a_offset_basis;
+			for (const auto &frame : prm_frames) {
+				hash = fnv1a_mix_address( hash, frame_address( frame ) );
+			}
+			return hash;
+		}
+
+	} // namespace detail
+
+	/// \brief Get the fingerprint of the stacktrace that TELL_THROW() captured in the specified exception
+	///        (or none if no stacktrace was captured)
+	///
+	/// This is computed from the frame addresses without symbolizing the frames so it's cheap enough
+	/// to use to decide whether a trace is worth rendering.
+	template <typename Ex>
+	::boost::optional<stack_fingerprint_t> get_stack_fingerprint(const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+	                                                             ) {
+		// Build the optional at the end (rather than assigning it in the lambda) to avoid spurious -Wmaybe-uninitialized warnings from GCC
+		stack_fingerprint_t fingerprint   = 0;
+		const bool          were_captured = detail::visit_captured_frames(
+			prm_exception,
+			[&] (const auto &x) {
+				fingerprint = detail::fingerprint_frames( x );
+			}
+		);
+		return were_captured ? ::boost::make_optional( fingerprint ) : ::boost::none;
+	}
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_STACK_FINGERPRINT_HPP
@@ -1,48 +1,82 @@
 #ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_STACKTRACE_TO_CLEANED_STRING_HPP
 #define _TELL_SOURCE_SRC_STACKTRACE_TELL_STACKTRACE_TO_CLEANED_STRING_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <utility>
 
-#include <boost/algorithm/cxx11/none_of.hpp>
-#include <boost/algorithm/string/join.hpp>
-#include <boost/algorithm/string/predicate.hpp>
-#include <boost/format.hpp>
-#include <boost/range/adaptor/filtered.hpp>
-#include <boost/range/adaptor/indexed.hpp>
-#include <boost/range/adaptor/transformed.hpp>
 #include <boost/stacktrace.hpp>
 
+#include "tell/detail/captured_frames.hpp"
+#include "tell/detail/sink_formatting.hpp"
+#include "tell/frame_prefix_matcher.hpp"
+#include "tell/output_sinks.hpp"
+#include "tell/symbol_cache.hpp"
+
 namespace tell { namespace except { namespace detail {
 
-	/// \brief Generate a string for the specified stacktrace, stripped of any frames from tell's throw_with_locn_and_stacktrace()
+	/// \brief Write a description of the specified frames to the specified sink, stripped of any frames whose function
+	///        names are matched by the specified matcher
+	///
+	/// Each frame is symbolized (via the symbol_cache) once, to both filter and render it. tell's own
+	/// frames are never captured in the first place (see attach_locn_and_stacktrace()) so don't need stripping here.
+	template <typename Sink, typename Frames>
+	void write_stripped_by_matcher(Sink                       &prm_sink,   ///< The sink to which the description should be written
+	                               const Frames               &prm_frames, ///< The frames to describe (a boost::stacktrace::stacktrace or raw_frames_t)
+	                               const frame_prefix_matcher &prm_matcher ///< The matcher of the function names of the frames to be filtered out
+	                               ) {
+		int64_t frame_ctr = 0;
+		for (const auto &frame : prm_frames) {
+			const void * const address         = frame_address( frame );
+			const auto         symbol_info_ptr = symbolize( address );
+			if ( prm_matcher.matches( symbol_info_ptr->function ) ) {
+				continue;
+			}
+			write_decimal( prm_sink, frame_ctr++, 4 );
+			prm_sink.write( "  ", 2 );
+			write_frame_description( prm_sink, address, *symbol_info_ptr );
+			prm_sink.write( "\n", 1 );
+		}
+	}
+
+	/// \brief Write a line to the specified sink that marks that a stacktrace was truncated after the specified number of frames
+	template <typename Sink>
+	void write_truncation_marker(Sink         &prm_sink,      ///< The sink to which the marker should be written
+	                             const size_t &prm_num_frames ///< The number of frames that were kept
+	                             ) {
+		write_cstring( prm_sink, "   ...  (truncated after " );
+		write_decimal( prm_sink, static_cast<int64_t>( prm_num_frames ) );
+		write_cstring( prm_sink, " frames)\n" );
+	}
+
+	/// \brief Generate a string for the specified frames, stripped of any frames whose function names are matched by the specified matcher
+	template <typename Frames>
+	inline ::std::string to_string_stripped_by_matcher(const Frames               &prm_frames, ///< The frames to describe (a boost::stacktrace::stacktrace or raw_frames_t)
+	                                                   const frame_prefix_matcher &prm_matcher ///< The matcher of the function names of the frames to be filtered out
+	                                                   ) {
+		::std::string result;
+		string_sink   sink{ result };
+		write_stripped_by_matcher( sink, prm_frames, prm_matcher );
+		return result;
+	}
+
+	/// \brief Generate a string for the specified frames, without stripping any
+	template <typename Frames>
+	inline ::std::string to_string_unstripped(const Frames &prm_frames ///< The frames to describe (a boost::stacktrace::stacktrace or raw_frames_t)
+	                                          ) {
+		return to_string_stripped_by_matcher( prm_frames, frame_prefix_matcher{} );
+	}
+
+	/// \brief Generate a string for the specified stacktrace, stripped of any frames whose function names start with any of the specified prefixes
+	///
+	/// This compiles the prefixes into a frame_prefix_matcher for each call; callers that render
+	/// repeatedly with the same prefixes should build one and use to_string_stripped_by_matcher()
 	template <typename Rng>
 	inline ::std::string to_string_stripped_by_prefixes(const ::boost::stacktrace::stacktrace  &prm_stacktrace,    ///< The stacktrace to describe
 	                                                    Rng                                   &&prm_strip_prefixes ///< A range of prefixes to specify the stacktrace entries to be filtered out
 	                                                    ) {
-		// Lambda closure for whether the argument's `.name()` reveals it comes from tell's throw_with_locn_and_stacktrace()
-		const auto is_outside_throw_context = [&] (const auto &x) {
-			return ::boost::algorithm::none_of(
-				prm_strip_prefixes,
-				[&] (auto &&y) {
-					return ::boost::algorithm::starts_with( x.name(), y );
-				}
-			);
-		};
-		// Loop over the acceptable frames and append a description of each to a string, then return the string
-		::std::string result;
-		return ::boost::algorithm::join(
-			prm_stacktrace
-				| ::boost::adaptors::filtered( is_outside_throw_context )
-				| ::boost::adaptors::indexed()
-				// | ::boost::adaptors::transformed( [] (const boost::range::index_value<const boost::stacktrace::frame &, long> &indexed_frame) {
-				| ::boost::adaptors::transformed( [] (const auto                                                              &indexed_frame) {
-					return ( ::boost::format( "%4d" ) % indexed_frame.index() ).str()
-						+ "  "
-						+ to_string( indexed_frame.value() )
-						+ "\n";
-				} ),
-			""
-		);
+		return to_string_stripped_by_matcher( prm_stacktrace, frame_prefix_matcher{ ::std::forward<Rng>( prm_strip_prefixes ) } );
 	}
 
 } // namespace detail
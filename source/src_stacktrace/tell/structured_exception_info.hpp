@@ -0,0 +1,453 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_STRUCTURED_EXCEPTION_INFO_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_STRUCTURED_EXCEPTION_INFO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include <boost/exception/get_error_info.hpp>
+
+#include "tell/capture_policy.hpp"
+#include "tell/detail/captured_frames.hpp"
+#include "tell/detail/sink_formatting.hpp"
+#include "tell/detail/type_name_cache.hpp"
+#include "tell/detail/types.hpp"
+#include "tell/output_sinks.hpp"
+#include "tell/retrieve_exception_info.hpp"
+#include "tell/symbol_cache.hpp"
+
+/// \file
+/// \brief Machine-readable renderings of the info retrieved from an exception thrown via TELL_THROW()
+///
+/// These cover the same information as retrieve_exception_info() but in forms that downstream tools
+/// can consume without parsing the human-readable text. Both are written field-by-field straight into
+/// a sink (see output_sinks.hpp) without building any intermediate representation.
+///
+/// The JSON form is a single compact object (with no whitespace) and any field whose value is
+/// unknown is omitted:
+///
+///     {"type":"...","throw_function":"...","throw_file":"...","throw_line":42,"what":"...",
+///      "stacktrace":[{"address":"0x...","module":"...","module_offset":"0x...","function":"...","file":"...","line":7},...]}
+///
+/// (or with "stacktrace_skipped_by":"<policy>" in place of "stacktrace" if the capture_policy skipped the capture).
+/// If the capture_depth truncated the stacktrace, "stacktrace_truncated_after":<number of frames kept> follows it.
+/// Addresses are strings of "0x" followed by 16 upper-case hex digits so they survive JSON parsers' doubles.
+///
+/// The binary form is the four bytes "TELL", a version byte (binary_format_version) and then a sequence of
+/// fields, each of which is a binary_field_tag byte, a 4-byte little-endian payload length and the payload.
+/// String payloads are the raw bytes (with no terminator); integer payloads are 8 bytes, little-endian.
+/// Each frame starts with a FRAME_ADDRESS field and the FRAME_... fields that follow it apply to that frame.
+/// The record ends with an END field (with an empty payload).
+
+namespace tell { namespace except {
+
+	/// \brief The version of the binary format written by write_exception_info_binary()
+	constexpr uint8_t binary_format_version = 1;
+
+	/// \brief The tags of the fields in the binary format written by write_exception_info_binary()
+	enum class binary_field_tag : uint8_t {
+		END                   = 0,  ///< The end of the record (with an empty payload)
+		TYPE                  = 1,  ///< The (demangled) dynamic type of the exception (string)
+		THROW_FUNCTION        = 2,  ///< The function from which the exception was thrown (string)
+		THROW_FILE            = 3,  ///< The file from which the exception was thrown (string)
+		THROW_LINE            = 4,  ///< The line from which the exception was thrown (integer)
+		WHAT                  = 5,  ///< The what() of the exception (string)
+		STACKTRACE_SKIPPED_BY = 6,  ///< A description of the capture_policy that skipped capturing the stacktrace (string)
+		STACKTRACE_TRUNCATED  = 7,  ///< The number of frames kept in a stacktrace that the capture_depth truncated, after the frames (integer)
+		FRAME_ADDRESS         = 16, ///< The address of a frame, which starts a new frame (integer)
+		FRAME_MODULE          = 17, ///< The module of the current frame (string)
+		FRAME_MODULE_OFFSET   = 18, ///< The address of the current frame relative to its module's load bias (integer)
+		FRAME_FUNCTION        = 19, ///< The function of the current frame (string)
+		FRAME_FILE            = 20, ///< The source file of the current frame (string)
+		FRAME_LINE            = 21  ///< The source line of the current frame (integer)
+	};
+
+	namespace detail {
+
+		/// \brief Write the specified chars to the specified sink as a JSON string (with quotes and escaping)
+		///
+		/// Bytes outside ASCII are passed through unchanged (so UTF-8 input gives UTF-8 output)
+		template <typename Sink>
+		void write_json_string(Sink               &prm_sink,     ///< The sink to which the string should be written
+		                       const char * const  prm_chars,    ///< The chars to write
+		                       const size_t       &prm_num_chars ///< The number of chars to write
+		                       ) {
+			prm_sink.write( "\"", 1 );
+			size_t run_begin = 0;
+			for (size_t char_ctr = 0; char_ctr < prm_num_chars; ++char_ctr) {
+				const auto  the_char = static_cast<unsigned char>( prm_chars[ char_ctr ] );
+				const char *escape   = nullptr;
+				switch ( the_char ) {
+					case '"'  : { escape = "\\\""; break; }
+					case '\\' : { escape = "\\\\"; break; }
+					case '\b' : { escape = "\\b";  break; }
+					case '\f' : { escape = "\\f";  break; }
+					case '\n' : { escape = "\\n";  break; }
+					case '\r' : { escape = "\\r";  break; }
+					case '\t' : { escape = "\\t";  break; }
+					default   : { break; }
+				}
+				if ( escape == nullptr && the_char >= 0x20 ) {
+					continue;
+				}
+				prm_sink.write( prm_chars + run_begin, char_ctr - run_begin );
+				if ( escape != nullptr ) {
+					write_cstring( prm_sink, escape );
+				}
+				else {
+					const char unicode_escape[ 6 ] = { '\\', 'u', '0', '0', "0123456789abcdef"[ the_char >> 4 ], "0123456789abcdef"[ the_char & 0xFu ] };
+					prm_sink.write( unicode_escape, sizeof( unicode_escape ) );
+				}
+				run_begin = char_ctr + 1;
+			}
+			prm_sink.write( prm_chars + run_begin, prm_num_chars - run_begin );
+			prm_sink.write( "\"", 1 );
+		}
+
+		/// \brief Write a JSON member with the specified key and string value (preceded by a comma unless it's the first)
+		template <typename Sink>
+		void write_json_string_member(Sink               &prm_sink,     ///< The sink to which the member should be written
+		                              bool               &prm_is_first, ///< Whether this is the first member of its object (which is updated)
+		                              const char * const  prm_key,      ///< The key (which mustn't need escaping)
+		                              const char * const  prm_chars,    ///< The chars of the value
+		                              const size_t       &prm_num_chars ///< The number of chars of the value
+		                              ) {
+			write_cstring( prm_sink, prm_is_first ? "\"" : ",\"" );
+			write_cstring( prm_sink, prm_key );
+			write_cstring( prm_sink, "\":" );
+			write_json_string( prm_sink, prm_chars, prm_num_chars );
+			prm_is_first = false;
+		}
+
+		/// \brief Write a JSON member with the specified key and a raw value (preceded by a comma unless it's the first)
+		template <typename Sink, typename Fn>
+		void write_json_raw_member(Sink               &prm_sink,     ///< The sink to which the member should be written
+		                           bool               &prm_is_first, ///< Whether this is the first member of its object (which is updated)
+		                           const char * const  prm_key,      ///< The key (which mustn't need escaping)
+		                           Fn                &&prm_value_fn  ///< A function to write the raw value to the sink
+		                           ) {
+			write_cstring( prm_sink, prm_is_first ? "\"" : ",\"" );
+			write_cstring( prm_sink, prm_key );
+			write_cstring( prm_sink, "\":" );
+			prm_value_fn();
+			prm_is_first = false;
+		}
+
+		/// \brief Write the specified value to the specified sink as 8 little-endian bytes
+		template <typename Sink>
+		void write_uint64_le(Sink           &prm_sink, ///< The sink to which the value should be written
+		                     const uint64_t &prm_value ///< The value to write
+		                     ) {
+			char bytes[ 8 ];
+			for (size_t byte_ctr = 0; byte_ctr < sizeof( bytes ); ++byte_ctr) {
+				bytes[ byte_ctr ] = static_cast<char>( ( prm_value >> ( 8 * byte_ctr ) ) & 0xFFu );
+			}
+			prm_sink.write( bytes, sizeof( bytes ) );
+		}
+
+		/// \brief Write the header of a binary field (its tag and payload length) to the specified sink
+		template <typename Sink>
+		void write_binary_field_header(Sink                   &prm_sink,        ///< The sink to which the header should be written
+		                               const binary_field_tag &prm_tag,         ///< The tag of the field
+		                               const uint32_t         &prm_payload_size ///< The number of bytes in the field's payload
+		                               ) {
+			const char header[ 5 ] = {
+				static_cast<char>( prm_tag ),
+				static_cast<char>( ( prm_payload_size       ) & 0xFFu ),
+				static_cast<char>( ( prm_payload_size >>  8 ) & 0xFFu ),
+				static_cast<char>( ( prm_payload_size >> 16 ) & 0xFFu ),
+				static_cast<char>( ( prm_payload_size >> 24 ) & 0xFFu )
+			};
+			prm_sink.write( header, sizeof( header ) );
+		}
+
+		/// \brief Write a binary field with the specified tag and string payload to the specified sink
+		///
+		/// Payloads too long for the 4-byte length are truncated
+		template <typename Sink>
+		void write_binary_string_field(Sink                   &prm_sink,     ///< The sink to which the field should be written
+		                               const binary_field_tag &prm_tag,      ///< The tag of the field
+		                               const char * const      prm_chars,    ///< The chars of the payload
+		                               const size_t           &prm_num_chars ///< The number of chars of the payload
+		                               ) {
+			const auto payload_size = static_cast<uint32_t>( ::std::min<size_t>( prm_num_chars, UINT32_MAX ) );
+			write_binary_field_header( prm_sink, prm_tag, payload_size );
+			prm_sink.write( prm_chars, payload_size );
+		}
+
+		/// \brief Write a binary field with the specified tag and integer payload to the specified sink
+		template <typename Sink>
+		void write_binary_integer_field(Sink                   &prm_sink, ///< The sink to which the field should be written
+		                                const binary_field_tag &prm_tag,  ///< The tag of the field
+		                                const uint64_t         &prm_value ///< The value of the payload
+		                                ) {
+			write_binary_field_header( prm_sink, prm_tag, 8 );
+			write_uint64_le( prm_sink, prm_value );
+		}
+
+		/// \brief Call the specified function with each of the structured items of info retrieved from the specified exception
+		///
+		/// The function is called as fn( tag, chars, num_chars ) for string items and fn( tag, value ) for integer ones,
+		/// using the binary_field_tag values to identify the items (in the order described for the binary format), which
+		/// lets the JSON and binary renderers share the gathering of the info.
+		template <typename Ex, typename Fn>
+		void visit_structured_exception_info(const Ex  &prm_exception, ///< The boost::exception, hopefully thrown via TELL_THROW
+		                                     Fn       &&prm_fn         ///< The function to call with each item
+		                                     ) {
+			const auto * const file_value_ptr     = ::boost::get_error_info< ::boost::throw_file     >( prm_exception );
+			const auto * const line_value_ptr     = ::boost::get_error_info< ::boost::throw_line     >( prm_exception );
+			const auto * const function_value_ptr = ::boost::get_error_info< ::boost::throw_function >( prm_exception );
+			const char * const what_ptr           = get_what_ptr_of_std_exception( prm_exception );
+			const char * const dynamic_type_name  = demangled_type_name( typeid( prm_exception ) ).c_str();
+
+			const auto visit_cstring = [&] (const binary_field_tag &x, const char * const y) {
+				prm_fn( x, y, ::std::strlen( y ) );
+			};
+
+			visit_cstring( binary_field_tag::TYPE, dynamic_type_name );
+			if ( function_value_ptr != nullptr ) {
+				visit_cstring( binary_field_tag::THROW_FUNCTION, *function_value_ptr );
+			}
+			if ( file_value_ptr != nullptr ) {
+				visit_cstring( binary_field_tag::THROW_FILE, *file_value_ptr );
+			}
+			if ( line_value_ptr != nullptr ) {
+				prm_fn( binary_field_tag::THROW_LINE, static_cast<uint64_t>( static_cast<int64_t>( *line_value_ptr ) ) );
+			}
+			if ( what_ptr != nullptr ) {
+				visit_cstring( binary_field_tag::WHAT, what_ptr );
+			}
+
+			visit_throw_record(
+				prm_exception,
+				[&] (const auto &x) {
+					if ( const auto * const frames_ptr = x.get_frames() ) {
+						for (const auto &frame : *frames_ptr) {
+							const void * const address         = frame_address( frame );
+							const auto         symbol_info_ptr = symbolize( address );
+							prm_fn( binary_field_tag::FRAME_ADDRESS, static_cast<uint64_t>( reinterpret_cast<uintptr_t>( address ) ) );
+							if ( ! symbol_info_ptr->module.empty() ) {
+								prm_fn( binary_field_tag::FRAME_MODULE,        symbol_info_ptr->module.data(), symbol_info_ptr->module.size() );
+								prm_fn( binary_field_tag::FRAME_MODULE_OFFSET, static_cast<uint64_t>( symbol_info_ptr->module_offset )       );
+							}
+							if ( ! symbol_info_ptr->function.empty() ) {
+								prm_fn( binary_field_tag::FRAME_FUNCTION,      symbol_info_ptr->function.data(), symbol_info_ptr->function.size() );
+							}
+							if ( symbol_info_ptr->line != 0 ) {
+								prm_fn( binary_field_tag::FRAME_FILE,          symbol_info_ptr->file.data(), symbol_info_ptr->file.size() );
+								prm_fn( binary_field_tag::FRAME_LINE,          static_cast<uint64_t>( symbol_info_ptr->line )         );
+							}
+						}
+						const auto truncation = x.get_truncation();
+						if ( truncation ) {
+							prm_fn( binary_field_tag::STACKTRACE_TRUNCATED, static_cast<uint64_t>( *truncation ) );
+						}
+					}
+					else if ( x.get_capture_skipped_by() ) {
+						const auto policy_description = to_string( *x.get_capture_skipped_by() );
+						prm_fn( binary_field_tag::STACKTRACE_SKIPPED_BY, policy_description.data(), policy_description.size() );
+					}
+				}
+			);
+		}
+
+		/// \brief A visitor for visit_structured_exception_info() that writes the items as JSON
+		template <typename Sink>
+		class json_exception_info_writer final {
+		private:
+			/// \brief The sink to which the JSON should be written
+			Sink &sink;
+
+			/// \brief Whether the next member of the top-level object is the first
+			bool is_first_member       = true;
+
+			/// \brief Whether the next member of the current frame's object is the first
+			bool is_first_frame_member = true;
+
+			/// \brief Whether any frames have been written
+			bool has_frames            = false;
+
+			/// \brief Whether the frames' array has been written and closed
+			bool frames_closed         = false;
+
+			/// \brief Get the key used in the JSON for the specified tag
+			static const char * key_of_tag(const binary_field_tag &prm_tag ///< The tag
+			                               ) {
+				switch ( prm_tag ) {
+					case binary_field_tag::TYPE                  : { return "type";                       }
+					case binary_field_tag::THROW_FUNCTION        : { return "throw_function";             }
+					case binary_field_tag::THROW_FILE            : { return "throw_file";                 }
+					case binary_field_tag::THROW_LINE            : { return "throw_line";                 }
+					case binary_field_tag::WHAT                  : { return "what";                       }
+					case binary_field_tag::STACKTRACE_SKIPPED_BY : { return "stacktrace_skipped_by";      }
+					case binary_field_tag::STACKTRACE_TRUNCATED  : { return "stacktrace_truncated_after"; }
+					case binary_field_tag::FRAME_ADDRESS         : { return "address";                    }
+					case binary_field_tag::FRAME_MODULE          : { return "module";                     }
+					case binary_field_tag::FRAME_MODULE_OFFSET   : { return "module_offset";              }
+					case binary_field_tag::FRAME_FUNCTION        : { return "function";                   }
+					case binary_field_tag::FRAME_FILE            : { return "file";                       }
+					case binary_field_tag::FRAME_LINE            : { return "line";                       }
+					case binary_field_tag::END                   : { break;                               }
+				}
+				return "unknown";
+			}
+
+			/// \brief Whether the specified tag is for a member of a frame's object
+			static bool is_frame_tag(const binary_field_tag &prm_tag ///< The tag
+			                         ) {
+				return ( static_cast<uint8_t>( prm_tag ) >= static_cast<uint8_t>( binary_field_tag::FRAME_ADDRESS ) );
+			}
+
+			/// \brief Prepare to write a member with the specified tag, opening/closing the frames' array/objects as required
+			///
+			/// \returns The is_first flag for the object to which the member belongs
+			bool & begin_member(const binary_field_tag &prm_tag ///< The tag of the member
+			                    ) {
+				if ( prm_tag == binary_field_tag::FRAME_ADDRESS ) {
+					write_cstring( sink, has_frames ? "}," : ( is_first_member ? "\"stacktrace\":[" : ",\"stacktrace\":[" ) );
+					write_cstring( sink, "{" );
+					has_frames            = true;
+					is_first_member       = false;
+					is_first_frame_member = true;
+				}
+				else if ( has_frames && ! frames_closed && ! is_frame_tag( prm_tag ) ) {
+					write_cstring( sink, "}]" );
+					frames_closed = true;
+				}
+				return is_frame_tag( prm_tag ) ? is_first_frame_member : is_first_member;
+			}
+
+		public:
+			/// \brief Ctor from the sink to which the JSON should be written, writing the opening of the object
+			explicit json_exception_info_writer(Sink &prm_sink ///< The sink to which the JSON should be written
+			                                    ) : sink{ prm_sink } {
+				write_cstring( sink, "{" );
+			}
+
+			/// \brief Write a string item
+			void operator()(const binary_field_tag &prm_tag,      ///< The tag of the item
+			                const char * const      prm_chars,    ///< The chars of the item
+			                const size_t           &prm_num_chars ///< The number of chars of the item
+			                ) {
+				write_json_string_member( sink, begin_member( prm_tag ), key_of_tag( prm_tag ), prm_chars, prm_num_chars );
+			}
+
+			/// \brief Write an integer item (addresses and offsets as hex strings, others as JSON numbers)
+			void operator()(const binary_field_tag &prm_tag,  ///< The tag of the item
+			                const uint64_t         &prm_value ///< The value of the item
+			                ) {
+				const bool is_address = ( prm_tag == binary_field_tag::FRAME_ADDRESS || prm_tag == binary_field_tag::FRAME_MODULE_OFFSET );
+				write_json_raw_member( sink, begin_member( prm_tag ), key_of_tag( prm_tag ), [&] {
+					if ( is_address ) {
+						sink.write( "\"", 1 );
+						write_hex( sink, prm_value );
+						sink.write( "\"", 1 );
+					}
+					else {
+						write_decimal( sink, static_cast<int64_t>( prm_value ) );
+					}
+				} );
+			}
+
+			/// \brief Write the closing of any frames' array and of the object
+			void finish() {
+				write_cstring( sink, ( has_frames && ! frames_closed ) ? "}]}" : "}" );
+			}
+		};
+
+		/// \brief A visitor for visit_structured_exception_info() that writes the items as binary fields
+		template <typename Sink>
+		class binary_exception_info_writer final {
+		private:
+			/// \brief The sink to which the fields should be written
+			Sink &sink;
+
+		public:
+			/// \brief Ctor from the sink to which the fields should be written, writing the magic and version
+			explicit binary_exception_info_writer(Sink &prm_sink ///< The sink to which the fields should be written
+			                                      ) : sink{ prm_sink } {
+				const char header[ 5 ] = { 'T', 'E', 'L', 'L', static_cast<char>( binary_format_version ) };
+				sink.write( header, sizeof( header ) );
+			}
+
+			/// \brief Write a string field
+			void operator()(const binary_field_tag &prm_tag,      ///< The tag of the field
+			                const char * const      prm_chars,    ///< The chars of the field
+			                const size_t           &prm_num_chars ///< The number of chars of the field
+			                ) {
+				write_binary_string_field( sink, prm_tag, prm_chars, prm_num_chars );
+			}
+
+			/// \brief Write an integer field
+			void operator()(const binary_field_tag &prm_tag,  ///< The tag of the field
+			                const uint64_t         &prm_value ///< The value of the field
+			                ) {
+				write_binary_integer_field( sink, prm_tag, prm_value );
+			}
+
+			/// \brief Write the END field
+			void finish() {
+				write_binary_field_header( sink, binary_field_tag::END, 0 );
+			}
+		};
+
+	} // namespace detail
+
+	/// \brief Write the info retrieved from the specified boost::exception (as added by TELL_THROW()) to the specified sink as compact JSON
+	///
+	/// The sink may be a std::ostream or any of the sinks in output_sinks.hpp. See the file documentation for the schema.
+	template <typename Sink, typename Ex>
+	void write_exception_info_json(Sink     &&prm_sink,     ///< The sink to which the JSON should be written
+	                               const Ex  &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+	                               ) {
+		static_assert( ::std::is_base_of<::boost::exception, detail::remove_cvref_t<Ex>>::value,
+			"tell can only write_exception_info_json() when passed with a static type derived from boost::exception (or boost::exception itself)" );
+
+		auto &&sink = detail::as_sink( prm_sink );
+		detail::json_exception_info_writer<::std::remove_reference_t<decltype( sink )>> writer{ sink };
+		detail::visit_structured_exception_info( prm_exception, writer );
+		writer.finish();
+	}
+
+	/// \brief Write the info retrieved from the specified boost::exception (as added by TELL_THROW()) to the specified sink
+	///        in tell's length-prefixed binary format
+	///
+	/// The sink may be a std::ostream or any of the sinks in output_sinks.hpp. See the file documentation for the format.
+	template <typename Sink, typename Ex>
+	void write_exception_info_binary(Sink     &&prm_sink,     ///< The sink to which the binary record should be written
+	                                 const Ex  &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+	                                 ) {
+		static_assert( ::std::is_base_of<::boost::exception, detail::remove_cvref_t<Ex>>::value,
+			"tell can only write_exception_info_binary() when passed with a static type derived from boost::exception (or boost::exception itself)" );
+
+		auto &&sink = detail::as_sink( prm_sink );
+		detail::binary_exception_info_writer<::std::remove_reference_t<decltype( sink )>> writer{ sink };
+		detail::visit_structured_exception_info( prm_exception, writer );
+		writer.finish();
+	}
+
+	/// \brief Generate a compact JSON string of the info retrieved from the specified boost::exception (as added by TELL_THROW())
+	template <typename Ex>
+	inline ::std::string retrieve_exception_info_json(const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+	                                                  ) {
+		::std::string result;
+		write_exception_info_json( string_sink{ result }, prm_exception );
+		return result;
+	}
+
+	/// \brief Generate a string of bytes in tell's length-prefixed binary format of the info retrieved from
+	///        the specified boost::exception (as added by TELL_THROW())
+	template <typename Ex>
+	inline ::std::string retrieve_exception_info_binary(const Ex &prm_exception ///< The boost::exception, hopefully thrown via TELL_THROW
+	                                                    ) {
+		::std::string result;
+		write_exception_info_binary( string_sink{ result }, prm_exception );
+		return result;
+	}
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_STRUCTURED_EXCEPTION_INFO_HPP
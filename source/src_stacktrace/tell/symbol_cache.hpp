@@ -0,0 +1,375 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_SYMBOL_CACHE_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_SYMBOL_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/stacktrace/frame.hpp>
+
+#if !defined( BOOST_WINDOWS ) && !defined( __GLIBC__ )
+#include <dlfcn.h>
+#endif
+
+#include "tell/detail/config.hpp"
+#include "tell/symbol_info.hpp"
+
+#if defined( __GLIBC__ )
+#include "tell/detail/loaded_module_map.hpp"
+#endif
+
+#if defined( TELL_USE_ELF_SYMBOLIZER )
+#include "tell/elf_symbolizer.hpp"
+#endif
+
+namespace tell { namespace except {
+
+	namespace detail {
+
+		/// \brief The module (executable or shared library) containing an address and the address's offset within it
+		struct module_location final {
+			/// \brief The name of the module, or empty if unknown
+			::std::string name;
+
+			/// \brief The address relative to the module's load bias, or 0 if unknown
+			uintptr_t     offset = 0;
+		};
+
+		/// \brief Locate the module (executable or shared library) containing the specified address
+		///
+		/// With glibc, this uses the loaded_module_map's snapshot rather than dladdr() (which takes the dynamic loader's global lock)
+		inline module_location locate_module_of_address(const void * const prm_address ///< The address to query
+		                                                ) {
+			module_location result;
+#if !defined( BOOST_WINDOWS )
+#if defined( __GLIBC__ )
+			// The offset is relative to the load bias, so it's the ELF virtual address (as used by the module's symbols)
+			const auto address    = reinterpret_cast<uintptr_t>( prm_address );
+			const auto * const the_module = loaded_module_map::instance().find( address );
+			if ( the_module != nullptr ) {
+				result.name   = the_module->name;
+				result.offset = address - the_module->load_bias;
+			}
+#else
+			::Dl_info dl_info;
+			if ( ::dladdr( prm_address, &dl_info ) != 0 ) {
+				if ( dl_info.dli_fname != nullptr ) {
+					result.name = dl_info.dli_fname;
+				}
+				result.offset = reinterpret_cast<uintptr_t>( prm_address ) - reinterpret_cast<uintptr_t>( dl_info.dli_fbase );
+			}
+#endif
+#endif
+			return result;
+		}
+
+		/// \brief Get the address to look up to symbolize the specified return address
+		///
+		/// Every address tell renders is a return address (tell's own frames, including the capturing one, are
+		/// skipped at capture time) which points to the instruction after the call. When the call is the last
+		/// instruction of its function (as when it calls a [[noreturn]] function like throw_with_locn_and_stacktrace())
+		/// that's the first instruction of the next function. So this steps back one byte, into the call instruction.
+		inline const void * call_lookup_address(const void * const prm_address ///< The return address
+		                                        ) {
+			return ( prm_address != nullptr ) ? static_cast<const char *>( prm_address ) - 1 : prm_address;
+		}
+
+		/// \brief Get the generation of the loaded modules, which changes whenever the loaded_module_map takes a new snapshot
+		///
+		/// Without glibc, there's no loaded_module_map so this is always 0
+		inline uint64_t loaded_modules_generation() noexcept {
+#if defined( __GLIBC__ )
+			return loaded_module_map::instance().get_generation();
+#else
+			return 0;
+#endif
+		}
+
+		/// \brief Symbolize the specified (return) address without any caching
+		///
+		/// This uses tell's in-process elf_symbolizer if TELL_USE_ELF_SYMBOLIZER is defined,
+		/// or the Boost Stacktrace backend otherwise
+		///
+		/// The function, file and line are those of the call (see call_lookup_address()); the module offset is that of the address itself
+		inline symbol_info symbolize_uncached(const void * const prm_address ///< The address to symbolize
+		                                      ) {
+			const void * const lookup_address = call_lookup_address( prm_address );
+#if defined( TELL_USE_ELF_SYMBOLIZER )
+			auto result = elf_symbolizer::instance().symbolize( lookup_address );
+			if ( ! result.module.empty() ) {
+				result.module_offset += static_cast<uintptr_t>( static_cast<const char *>( prm_address ) - static_cast<const char *>( lookup_address ) );
+			}
+			return result;
+#else
+			const ::boost::stacktrace::frame the_frame{ lookup_address };
+			auto the_module_location = locate_module_of_address( prm_address );
+			return {
+				the_frame.name(),
+				the_frame.source_file(),
+				the_frame.source_line(),
+				::std::move( the_module_location.name ),
+				the_module_location.offset
+			};
+#endif
+		}
+
+	} // namespace detail
+
+	/// \brief A snapshot of a symbol_cache's counters
+	struct symbol_cache_stats final {
+		/// \brief The number of lookups that were answered from the cache
+		size_t hits      = 0;
+
+		/// \brief The number of lookups that required symbolization
+		size_t misses    = 0;
+
+		/// \brief The number of entries that have been evicted to keep within the capacity
+		size_t evictions = 0;
+
+		/// \brief The number of entries currently in the cache
+		size_t size      = 0;
+
+		/// \brief The maximum number of entries the cache will hold
+		size_t capacity  = 0;
+	};
+
+	/// \brief A thread-safe, bounded cache from code address to symbol_info
+	///
+	/// Symbolization (particularly with the addr2line backend, which spawns a process per query)
+	/// is expensive, whereas the addresses seen in error paths tend to recur. This caches the result
+	/// of symbolizing each address so that repeated renderings cost a hash lookup.
+	///
+	/// The addresses are spread over independently-locked shards so that threads rendering concurrently
+	/// rarely contend. A hit only holds its shard's lock for the hash lookup and the setting of the entry's
+	/// reference bit: eviction uses the CLOCK approximation of least-recently-used, so hits don't reorder anything.
+	///
+	/// Symbolization of a missing address is performed outside the lock so that one slow lookup
+	/// doesn't stall other threads' hits.
+	///
+	/// Each entry records the loaded_module_map generation under which it was symbolized and is treated as a
+	/// miss once a new snapshot has been taken (eg by loaded_module_map::refresh() after a dlclose() and dlopen())
+	/// so that code mapped over an unloaded module's addresses isn't reported with the unloaded module's symbols.
+	///
+	/// Use instance() to get the process-wide cache that all of tell's rendering uses.
+	class symbol_cache final {
+	public:
+		/// \brief Type alias for a shared pointer to an immutable symbol_info
+		using symbol_info_cptr = ::std::shared_ptr<const symbol_info>;
+
+	private:
+		/// \brief The number of shards
+		static constexpr size_t num_shards = 16;
+
+		/// \brief An entry: the address, its symbol_info, the modules' generation and whether it's been used since the clock hand last passed it
+		struct entry final {
+			/// \brief The address
+			const void       *address;
+
+			/// \brief The symbol_info for the address
+			symbol_info_cptr  the_symbol_info;
+
+			/// \brief The generation of the loaded modules when the address was symbolized (see detail::loaded_modules_generation())
+			uint64_t          modules_generation;
+
+			/// \brief Whether the entry has been used since the clock hand last passed it
+			bool              referenced;
+		};
+
+		/// \brief A single shard of the cache
+		struct shard final {
+			/// \brief Mutex to protect entries, index and clock_hand
+			mutable ::std::mutex mutex;
+
+			/// \brief The entries, in no particular order
+			::std::vector<entry> entries;
+
+			/// \brief An index from address to the entry's position in entries
+			::std::unordered_map<const void *, size_t> index;
+
+			/// \brief The position in entries of the next candidate for eviction
+			size_t clock_hand = 0;
+		};
+
+		/// \brief The shards
+		::std::array<shard, num_shards> shards;
+
+		/// \brief The maximum number of entries to hold in each shard
+		::std::atomic<size_t> shard_capacity;
+
+		/// \brief The number of lookups that were answered from the cache
+		::std::atomic<size_t> num_hits{ 0 };
+
+		/// \brief The number of lookups that required symbolization
+		::std::atomic<size_t> num_misses{ 0 };
+
+		/// \brief The number of entries that have been evicted to keep within the capacity
+		::std::atomic<size_t> num_evictions{ 0 };
+
+		/// \brief Get the shard for the specified address
+		shard & shard_of(const void * const prm_address ///< The address
+		                 ) {
+			// Fibonacci hashing, taking the high bits (which depend on all of the address's bits)
+			const auto hash = static_cast<uint64_t>( reinterpret_cast<uintptr_t>( prm_address ) ) * UINT64_C( 0x9E3779B97F4A7C15 );
+			return shards[ static_cast<size_t>( hash >> 60 ) % num_shards ];
+		}
+
+		/// \brief Evict the entry that the clock hand selects from the specified (non-empty) shard
+		///
+		/// The shard's mutex must be held by the caller
+		void evict_one(shard &prm_shard ///< The shard from which to evict an entry
+		               ) {
+			auto &the_entries = prm_shard.entries;
+			// Give each referenced entry a second chance, clearing its bit as the hand passes
+			while ( true ) {
+				if ( prm_shard.clock_hand >= the_entries.size() ) {
+					prm_shard.clock_hand = 0;
+				}
+				if ( ! the_entries[ prm_shard.clock_hand ].referenced ) {
+					break;
+				}
+				the_entries[ prm_shard.clock_hand ].referenced = false;
+				++prm_shard.clock_hand;
+			}
+
+			// Remove the victim by moving the last entry into its position
+			const size_t victim_pos = prm_shard.clock_hand;
+			prm_shard.index.erase( the_entries[ victim_pos ].address );
+			if ( victim_pos + 1 != the_entries.size() ) {
+				the_entries[ victim_pos ] = ::std::move( the_entries.back() );
+				prm_shard.index[ the_entries[ victim_pos ].address ] = victim_pos;
+			}
+			the_entries.pop_back();
+			++num_evictions;
+		}
+
+		/// \brief Evict entries from the specified shard until its size is within the capacity
+		///
+		/// The shard's mutex must be held by the caller
+		void evict_to_capacity(shard &prm_shard ///< The shard from which to evict entries
+		                       ) {
+			const size_t capacity = shard_capacity.load( ::std::memory_order_relaxed );
+			while ( prm_shard.entries.size() > capacity ) {
+				evict_one( prm_shard );
+			}
+		}
+
+	public:
+		/// \brief Ctor from the capacity
+		explicit symbol_cache(const size_t &prm_capacity = TELL_SYMBOL_CACHE_CAPACITY ///< The maximum number of entries to hold (rounded up to a multiple of the number of shards)
+		                      ) : shard_capacity{ ( prm_capacity + num_shards - 1 ) / num_shards } {
+		}
+
+		/// \brief Get the symbol_info for the specified address, symbolizing it with the specified function if it isn't cached
+		template <typename Fn>
+		symbol_info_cptr get(const void * const  prm_address,   ///< The address to look up
+		                     Fn                &&prm_symbolizer ///< The function to symbolize the address if it's not cached
+		                     ) {
+			auto &the_shard = shard_of( prm_address );
+			// Read before symbolizing so that, if a new snapshot is taken meanwhile, the entry is already stale
+			const uint64_t generation = detail::loaded_modules_generation();
+			{
+				const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+				const auto find_itr = the_shard.index.find( prm_address );
+				if ( find_itr != the_shard.index.end() && the_shard.entries[ find_itr->second ].modules_generation >= generation ) {
+					auto &the_entry = the_shard.entries[ find_itr->second ];
+					the_entry.referenced = true;
+					++num_hits;
+					return the_entry.the_symbol_info;
+				}
+			}
+
+			++num_misses;
+			auto result = ::std::make_shared<const symbol_info>( ::std::forward<Fn>( prm_symbolizer )( prm_address ) );
+
+			const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+			// Another thread may have inserted this address while the lock wasn't held, in which case use theirs
+			// (unless it's stale, in which case replace it in place)
+			const auto find_itr = the_shard.index.find( prm_address );
+			if ( find_itr != the_shard.index.end() ) {
+				auto &the_entry = the_shard.entries[ find_itr->second ];
+				if ( the_entry.modules_generation >= generation ) {
+					return the_entry.the_symbol_info;
+				}
+				the_entry.the_symbol_info    = result;
+				the_entry.modules_generation = generation;
+				return result;
+			}
+			const size_t capacity = shard_capacity.load( ::std::memory_order_relaxed );
+			if ( capacity > 0 ) {
+				if ( the_shard.entries.size() >= capacity ) {
+					evict_one( the_shard );
+				}
+				the_shard.index.emplace( prm_address, the_shard.entries.size() );
+				the_shard.entries.push_back( entry{ prm_address, result, generation, false } );
+			}
+			return result;
+		}
+
+		/// \brief Get the symbol_info for the specified address, symbolizing it with symbolize_uncached() if it isn't cached
+		symbol_info_cptr get(const void * const prm_address ///< The address to look up
+		                     ) {
+			return get( prm_address, &detail::symbolize_uncached );
+		}
+
+		/// \brief Set the maximum number of entries to hold (rounded up to a multiple of the number of shards), evicting any entries beyond that
+		void set_capacity(const size_t &prm_capacity ///< The maximum number of entries to hold
+		                  ) {
+			shard_capacity.store( ( prm_capacity + num_shards - 1 ) / num_shards );
+			for (auto &the_shard : shards) {
+				const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+				evict_to_capacity( the_shard );
+			}
+		}
+
+		/// \brief Remove all entries (without resetting the counters)
+		void clear() {
+			for (auto &the_shard : shards) {
+				const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+				the_shard.index.clear();
+				the_shard.entries.clear();
+				the_shard.clock_hand = 0;
+			}
+		}
+
+		/// \brief Get a snapshot of the cache's counters
+		symbol_cache_stats stats() const {
+			symbol_cache_stats result;
+			for (const auto &the_shard : shards) {
+				const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+				result.size += the_shard.entries.size();
+			}
+			result.hits      = num_hits.load();
+			result.misses    = num_misses.load();
+			result.evictions = num_evictions.load();
+			result.capacity  = shard_capacity.load() * num_shards;
+			return result;
+		}
+
+		/// \brief Get the process-wide symbol_cache that tell uses for all its stacktrace rendering
+		static symbol_cache & instance() {
+			static symbol_cache the_instance;
+			return the_instance;
+		}
+	};
+
+	namespace detail {
+
+		/// \brief Get the symbol_info for the specified address via the process-wide symbol_cache
+		inline symbol_cache::symbol_info_cptr symbolize(const void * const prm_address ///< The address to symbolize
+		                                                ) {
+			return symbol_cache::instance().get( prm_address );
+		}
+
+	} // namespace detail
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_SYMBOL_CACHE_HPP
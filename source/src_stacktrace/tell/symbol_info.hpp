@@ -0,0 +1,77 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_SYMBOL_INFO_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_SYMBOL_INFO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "tell/detail/sink_formatting.hpp"
+#include "tell/output_sinks.hpp"
+
+namespace tell { namespace except {
+
+	/// \brief The symbolic information about a single code address
+	struct symbol_info final {
+		/// \brief The (demangled) name of the function containing the address, or empty if unknown
+		::std::string function;
+
+		/// \brief The source file containing the address, or empty if unknown
+		::std::string file;
+
+		/// \brief The source line containing the address, or 0 if unknown
+		size_t line = 0;
+
+		/// \brief The name of the module (executable or shared library) containing the address, or empty if unknown
+		::std::string module;
+
+		/// \brief The address relative to the module's load bias (ie the module's own virtual address for it,
+		///        which is what addr2line expects for the module), or 0 if unknown
+		uintptr_t module_offset = 0;
+	};
+
+	namespace detail {
+
+		/// \brief Write a description of the specified frame from its address and symbol_info to the specified sink
+		///
+		/// This matches the format of Boost Stacktrace's to_string(const frame &)
+		template <typename Sink>
+		void write_frame_description(Sink              &prm_sink,           ///< The sink to which the description should be written
+		                             const void        * const prm_address, ///< The address of the frame
+		                             const symbol_info &prm_symbol_info     ///< The symbolic information about the address
+		                             ) {
+			if ( prm_symbol_info.function.empty() ) {
+				write_hex( prm_sink, reinterpret_cast<uintptr_t>( prm_address ) );
+			}
+			else {
+				write_string( prm_sink, prm_symbol_info.function );
+			}
+			if ( prm_symbol_info.line != 0 ) {
+				prm_sink.write( " at ", 4 );
+				write_string( prm_sink, prm_symbol_info.file );
+				prm_sink.write( ":", 1 );
+				write_decimal( prm_sink, static_cast<int64_t>( prm_symbol_info.line ) );
+			}
+			else if ( ! prm_symbol_info.module.empty() ) {
+				prm_sink.write( " in ", 4 );
+				write_string( prm_sink, prm_symbol_info.module );
+			}
+		}
+
+	} // namespace detail
+
+	/// \brief Generate a string describing the specified frame from its address and symbol_info
+	///
+	/// This matches the format of Boost Stacktrace's to_string(const frame &)
+	inline ::std::string to_string(const void        * const prm_address, ///< The address of the frame
+	                               const symbol_info &prm_symbol_info     ///< The symbolic information about the address
+	                               ) {
+		::std::string result;
+		string_sink   sink{ result };
+		detail::write_frame_description( sink, prm_address, prm_symbol_info );
+		return result;
+	}
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_SYMBOL_INFO_HPP
@@ -1,33 +1,114 @@
 #ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_TELL_THROW_HPP
 #define _TELL_SOURCE_SRC_STACKTRACE_TELL_TELL_THROW_HPP
 
+#include <utility>
+
 #include <boost/stacktrace.hpp>
 
+#include "tell/capture_policy.hpp"
+#include "tell/detail/bounded_stacktrace.hpp"
+#include "tell/detail/raw_frames.hpp"
+#include "tell/detail/throw_record.hpp"
+#include "tell/detail/throw_site.hpp"
 #include "tell/detail/types.hpp"
+#include "tell/instrumentation.hpp"
+
+/// \brief Mark a function as unlikely to be called, so the compiler optimizes it for size and keeps it away from hot code
+#if defined( __GNUC__ )
+#define TELL_DETAIL_COLD __attribute__(( cold ))
+#else
+#define TELL_DETAIL_COLD
+#endif
 
 namespace tell { namespace except { namespace detail {
 
-	/// \brief Use Boost exception to decorate the specified argument with the throw location and stacktrace
+#if defined( TELL_USE_RAW_FRAMES )
+
+	/// \brief Type alias for the type into which TELL_THROW() captures the stack
+	using throw_frames_t = raw_frames_t;
+
+	/// \brief Type alias for the error_info in which TELL_THROW() attaches its throw_record
+	using throw_record_error_info_t = boost_exception_raw_frames_record_error_info;
+
+#else
+
+	/// \brief Type alias for the type into which TELL_THROW() captures the stack
+	using throw_frames_t = bounded_stacktrace;
+
+	/// \brief Type alias for the error_info in which TELL_THROW() attaches its throw_record
+	using throw_record_error_info_t = boost_exception_stacktrace_record_error_info;
+
+#endif
+
+	/// \brief Attach the throw location and (subject to the site's capture_policy) the stacktrace to the specified exception
 	///
-	/// Don't use this directly - call it via the TELL_THROW() macro
+	/// This holds all the work of TELL_THROW() that doesn't depend on the exception's type, so there's a
+	/// single copy of it in the program rather than one per exception type. It's never inlined and is
+	/// marked cold so that the compiler keeps it (and everything it calls) away from the hot code.
+	///
+	/// The stacktrace is only captured if the site's capture_policy says so; otherwise
+	/// the policy is recorded in its place so that retrieve_exception_info() can report it.
+	/// Either way, it's attached as a single throw_record (so costs a single error_info) and the
+	/// location goes in boost::exception's dedicated members for it (so costs no allocation).
 	///
 	/// It's better to have the call to stacktrace() in the body of this function rather
 	/// than in the call because otherwise the stack on clang+addr2line can miss out a
 	/// decent location for the call.
+	///
+	/// If TELL_ENABLE_INSTRUMENTATION is defined, the throw and the capture's cost are recorded against the site.
+	///
+	/// The capture skips two frames (this one and that of throw_with_locn_and_stacktrace(), which is also never
+	/// inlined) plus any more specified by the site's capture_depth. That way, tell's own frames are dropped at
+	/// capture time, so rendering and fingerprinting needn't symbolize the frames to find and strip them.
+	/// The capture stops at the capture_depth's max_depth and, if the stack was deeper, the frames record
+	/// that they were truncated so that the rendering can say so.
+	BOOST_NOINLINE TELL_DETAIL_COLD inline void attach_locn_and_stacktrace(const ::boost::exception     &prm_exception, ///< The exception to which the information should be attached
+	                                                                       const throw_function_value_t &prm_function,  ///< The name of the function containing the code that wants to throw
+	                                                                       const throw_file_value_t     &prm_file,      ///< The name of the source file containing the code that wants to throw
+	                                                                       const throw_line_value_t     &prm_line,      ///< The number of the source line containing the code that wants to throw
+	                                                                       throw_site                   &prm_site       ///< The state of the site containing the code that wants to throw
+	                                                                       ) {
+		prm_exception
+			<< ::boost::throw_function               ( prm_function                      )
+			<< ::boost::throw_file                   ( prm_file                          )
+			<< ::boost::throw_line                   ( prm_line                          );
+		if ( prm_site.should_capture() ) {
+			const auto depth = prm_site.get_depth();
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+			const auto capture_start = instrumentation_clock::now();
+#endif
+			auto frames = throw_frames_t::capture( 2 + depth.get_skip(), max_depth_to_capture( depth ) );
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+			record_throw( prm_function, prm_file, prm_line, nanoseconds_since( capture_start ), frames.size() );
+#endif
+			prm_exception << throw_record_error_info_t{ throw_record<throw_frames_t>::captured( ::std::move( frames ) ) };
+		}
+		else {
+#if defined( TELL_ENABLE_INSTRUMENTATION )
+			record_uncaptured_throw( prm_function, prm_file, prm_line );
+#endif
+			prm_exception << throw_record_error_info_t{ throw_record<throw_frames_t>::skipped( prm_site.get_policy() ) };
+		}
+	}
+
+	/// \brief Use Boost exception to decorate the specified exception with the throw location and stacktrace
+	///
+	/// Don't use this directly - call it via the TELL_THROW() macro
+	///
+	/// There's one of these per exception type (not per site) and it does the minimum that depends on the
+	/// type: wrap the exception, pass it to attach_locn_and_stacktrace() (which does everything that doesn't
+	/// depend on the exception's type) and throw it. It's never inlined and is marked cold, so each site is
+	/// left with just the evaluation of the exception and a call that the compiler knows won't return.
 	template <typename Ex>
-	void throw_with_locn_and_stacktrace(Ex                                    &&prm_exception, ///< The thing to be decorated and then thrown
-	                                    const throw_function_value_t           &prm_function,  ///< The name of the function containing the code that wants to throw
-	                                    const throw_file_value_t               &prm_file,      ///< The name of the source file containing the code that wants to throw
-	                                    const throw_line_value_t               &prm_line       ///< The number of the source line containing the code that wants to throw
-	                                    )
-	{
-		throw (
-			::boost::enable_error_info( std::forward<Ex>( prm_exception ) )
-				<< ::boost::throw_function               ( prm_function                      )
-				<< ::boost::throw_file                   ( prm_file                          )
-				<< ::boost::throw_line                   ( prm_line                          )
-				<< boost_exception_stacktrace_error_info ( ::boost::stacktrace::stacktrace() )
-		);
+	[[noreturn]] BOOST_NOINLINE TELL_DETAIL_COLD void throw_with_locn_and_stacktrace(Ex                           &&prm_exception, ///< The thing to be decorated and then thrown
+	                                                                                 const throw_function_value_t   prm_function,  ///< The name of the function containing the code that wants to throw
+	                                                                                 const throw_file_value_t       prm_file,      ///< The name of the source file containing the code that wants to throw
+	                                                                                 const throw_line_value_t       prm_line,      ///< The number of the source line containing the code that wants to throw
+	                                                                                 throw_site                    &prm_site       ///< The state of the site containing the code that wants to throw
+	                                                                                 ) {
+		auto the_exception = ::boost::enable_error_info( ::std::forward<Ex>( prm_exception ) );
+		attach_locn_and_stacktrace( the_exception, prm_function, prm_file, prm_line, prm_site );
+		throw the_exception;
 	}
 
 } // namespace detail
@@ -35,6 +116,9 @@ namespace tell { namespace except { namespace detail {
 } // namespace tell
 
 /// \brief Use Boost exception to decorate the specified argument with the throw location and stacktrace
-#define TELL_THROW(x) ::tell::except::detail::throw_with_locn_and_stacktrace( ((x)), BOOST_THROW_EXCEPTION_CURRENT_FUNCTION, __FILE__, __LINE__ )
+///
+/// Whether the stacktrace is captured is governed by the site's capture_policy and which frames are captured
+/// by its capture_depth (see capture_policy.hpp)
+#define TELL_THROW(x) ::tell::except::detail::throw_with_locn_and_stacktrace( ((x)), BOOST_THROW_EXCEPTION_CURRENT_FUNCTION, __FILE__, __LINE__, TELL_DETAIL_THROW_SITE() )
 
 #endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_TELL_THROW_HPP
@@ -0,0 +1,165 @@
+#ifndef _TELL_SOURCE_SRC_STACKTRACE_TELL_TRACE_REGISTRY_HPP
+#define _TELL_SOURCE_SRC_STACKTRACE_TELL_TRACE_REGISTRY_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tell/detail/config.hpp"
+#include "tell/stack_fingerprint.hpp"
+
+namespace tell { namespace except {
+
+	/// \brief A snapshot of a trace_registry's counters
+	struct trace_registry_stats final {
+		/// \brief The number of distinct fingerprints currently tracked
+		size_t distinct  = 0;
+
+		/// \brief The total number of occurrences recorded against tracked fingerprints
+		size_t total     = 0;
+
+		/// \brief The number of occurrences that couldn't be tracked because the registry was full
+		size_t untracked = 0;
+
+		/// \brief The maximum number of distinct fingerprints the registry will track
+		size_t capacity  = 0;
+	};
+
+	/// \brief A thread-safe, bounded registry of the number of times each stack fingerprint has been seen
+	///
+	/// This is used to render each distinct stacktrace in full only the first time it's seen.
+	///
+	/// The fingerprints are spread over independently-locked shards so that threads recording
+	/// different traces rarely contend. Once a shard is full, new fingerprints in that shard aren't
+	/// tracked (and record() returns 0 for them, so callers treat them as seen for the first time)
+	/// which errs on the side of rendering too much rather than losing traces.
+	///
+	/// Use instance() to get the process-wide registry that retrieve_exception_info_deduplicated() uses.
+	class trace_registry final {
+	private:
+		/// \brief The number of shards
+		static constexpr size_t num_shards = 16;
+
+		/// \brief A single shard of the registry
+		struct shard final {
+			/// \brief Mutex to protect counts
+			mutable ::std::mutex mutex;
+
+			/// \brief The number of times each fingerprint in this shard has been seen
+			::std::unordered_map<stack_fingerprint_t, uint64_t> counts;
+		};
+
+		/// \brief The shards
+		::std::array<shard, num_shards> shards;
+
+		/// \brief The maximum number of distinct fingerprints to track in each shard
+		::std::atomic<size_t> shard_capacity;
+
+		/// \brief The number of occurrences that couldn't be tracked because the registry was full
+		::std::atomic<size_t> num_untracked{ 0 };
+
+		/// \brief Get the shard for the specified fingerprint
+		shard & shard_of(const stack_fingerprint_t &prm_fingerprint ///< The fingerprint
+		                 ) {
+			// Use the high bits, which FNV-1a mixes better than the low bits
+			return shards[ static_cast<size_t>( prm_fingerprint >> 60 ) % num_shards ];
+		}
+
+		/// \brief Get the shard for the specified fingerprint
+		const shard & shard_of(const stack_fingerprint_t &prm_fingerprint ///< The fingerprint
+		                       ) const {
+			return shards[ static_cast<size_t>( prm_fingerprint >> 60 ) % num_shards ];
+		}
+
+	public:
+		/// \brief Ctor from the capacity
+		explicit trace_registry(const size_t &prm_capacity = TELL_TRACE_REGISTRY_CAPACITY ///< The maximum number of distinct fingerprints to track
+		                        ) : shard_capacity{ ( prm_capacity + num_shards - 1 ) / num_shards } {
+		}
+
+		/// \brief Record an occurrence of the specified fingerprint
+		///
+		/// \returns The number of times the fingerprint has now been seen (so 1 on first sight)
+		///          or 0 if the registry is full and the fingerprint isn't tracked
+		uint64_t record(const stack_fingerprint_t &prm_fingerprint ///< The fingerprint
+		                ) {
+			auto &the_shard = shard_of( prm_fingerprint );
+			const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+			const auto find_itr = the_shard.counts.find( prm_fingerprint );
+			if ( find_itr != the_shard.counts.end() ) {
+				return ++( find_itr->second );
+			}
+			if ( the_shard.counts.size() >= shard_capacity.load( ::std::memory_order_relaxed ) ) {
+				++num_untracked;
+				return 0;
+			}
+			the_shard.counts.emplace( prm_fingerprint, 1 );
+			return 1;
+		}
+
+		/// \brief Get the number of times the specified fingerprint has been seen (or 0 if it isn't tracked)
+		uint64_t count(const stack_fingerprint_t &prm_fingerprint ///< The fingerprint
+		               ) const {
+			const auto &the_shard = shard_of( prm_fingerprint );
+			const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+			const auto find_itr = the_shard.counts.find( prm_fingerprint );
+			return ( find_itr != the_shard.counts.end() ) ? find_itr->second : 0;
+		}
+
+		/// \brief Get a copy of every tracked fingerprint with the number of times it's been seen
+		::std::vector<::std::pair<stack_fingerprint_t, uint64_t>> snapshot() const {
+			::std::vector<::std::pair<stack_fingerprint_t, uint64_t>> result;
+			for (const auto &the_shard : shards) {
+				const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+				result.insert( result.end(), the_shard.counts.begin(), the_shard.counts.end() );
+			}
+			return result;
+		}
+
+		/// \brief Set the maximum number of distinct fingerprints to track
+		///
+		/// This doesn't discard any fingerprints that are already tracked
+		void set_capacity(const size_t &prm_capacity ///< The maximum number of distinct fingerprints to track
+		                  ) {
+			shard_capacity.store( ( prm_capacity + num_shards - 1 ) / num_shards );
+		}
+
+		/// \brief Forget all fingerprints (so each will be treated as first seen again) and reset the counters
+		void clear() {
+			for (auto &the_shard : shards) {
+				const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+				the_shard.counts.clear();
+			}
+			num_untracked.store( 0 );
+		}
+
+		/// \brief Get a snapshot of the registry's counters
+		trace_registry_stats stats() const {
+			trace_registry_stats result;
+			for (const auto &the_shard : shards) {
+				const ::std::lock_guard<::std::mutex> lock{ the_shard.mutex };
+				result.distinct += the_shard.counts.size();
+				for (const auto &count_entry : the_shard.counts) {
+					result.total += count_entry.second;
+				}
+			}
+			result.untracked = num_untracked.load();
+			result.capacity  = shard_capacity.load() * num_shards;
+			return result;
+		}
+
+		/// \brief Get the process-wide trace_registry
+		static trace_registry & instance() {
+			static trace_registry the_instance;
+			return the_instance;
+		}
+	};
+
+} // namespace except
+} // namespace tell
+
+#endif // _TELL_SOURCE_SRC_STACKTRACE_TELL_TRACE_REGISTRY_HPP
@@ -97,6 +97,9 @@ int main() {
 	}
 	catch (const my::stuff::app_exception_base &exception) {
 		cerr << TELL_RETRIEVE_EXCEPTION_INFO( exception ) << flush;
+
+		// The same stacktrace is only rendered in full the first time it's seen
+		cerr << TELL_RETRIEVE_EXCEPTION_INFO_DEDUPLICATED( exception ) << flush;
 	}
 }
 
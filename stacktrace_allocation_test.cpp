@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include <boost/core/ignore_unused.hpp>
+#include <boost/format.hpp>
+
+#include "tell/capture_policy.hpp"
+#include "tell/detail/raw_frames.hpp"
+#include "tell/output_sinks.hpp"
+#include "tell/retrieve_exception_info.hpp"
+#include "tell/tell_throw.hpp"
+
+#include "allocation_counter.hpp"
+
+/// \file
+/// \brief A test of the numbers of allocations that tell documents for capturing, throwing and rendering
+///
+/// This exits with a non-zero status if any operation makes more calls to the global operator new than
+/// documented (see the comment at the bottom of stacktrace_benchmark.cpp) so that a change that adds
+/// allocations to any of these paths fails the test rather than only showing in the benchmark's CSV.
+
+using ::std::cout;
+
+namespace {
+
+	/// \brief The number of allocations that TELL_THROW() makes when it captures a stacktrace
+	///
+	/// That's the four of the throw_record's single error_info (the exception's error_info map, the map node,
+	/// the value and its shared_ptr's control block) plus the stacktrace's own frames unless TELL_USE_RAW_FRAMES is defined.
+#if defined( TELL_USE_RAW_FRAMES )
+	constexpr size_t tell_throw_allocations = 4;
+#else
+	constexpr size_t tell_throw_allocations = 5;
+#endif
+
+	/// \brief The number of allocations that TELL_THROW() makes when the site's capture_policy skips the capture
+	constexpr size_t tell_throw_skipped_allocations = 4;
+
+	/// \brief The number of times each operation is checked (after one untimed call to warm up any caches)
+	constexpr size_t num_calls = 100;
+
+	/// \brief The exception type thrown in the tests
+	struct test_exception : public virtual ::boost::exception,
+	                        public virtual ::std::exception {
+		/// \brief Return a fixed message
+		const char * what() const noexcept final {
+			return "test exception";
+		}
+	};
+
+	/// \brief A counter incremented after each nested call in call_at_depth(), which stops the calls being tail calls
+	::std::atomic<size_t> num_nested_returns{ 0 };
+
+	/// \brief Call the specified function from within the specified number of nested (non-inlined) frames
+	template <typename Fn>
+	BOOST_NOINLINE void call_at_depth(const size_t  &prm_depth, ///< The number of nested frames from which to call the function
+	                                  Fn           &&prm_fn     ///< The function to call
+	                                  ) {
+		if ( prm_depth <= 1 ) {
+			prm_fn();
+		}
+		else {
+			call_at_depth( prm_depth - 1, prm_fn );
+		}
+		num_nested_returns.fetch_add( 1, ::std::memory_order_relaxed );
+	}
+
+	/// \brief Whether the tests' TELL_THROW()s should throw (always true; this just stops GCC judging call_at_depth() infinitely recursive)
+	::std::atomic<bool> should_throw{ true };
+
+	/// \brief Throw a test_exception via TELL_THROW() from within the specified number of nested frames and catch it
+	BOOST_NOINLINE void tell_throw_and_catch_at_depth(const size_t &prm_depth ///< The number of nested frames from which to throw
+	                                                  ) {
+		try {
+			call_at_depth( prm_depth, [] {
+				if ( should_throw.load( ::std::memory_order_relaxed ) ) {
+					TELL_THROW( test_exception{} );
+				}
+			} );
+		}
+		catch (const test_exception &) {
+		}
+	}
+
+	/// \brief Throw a test_exception via TELL_THROW() from within the specified number of nested frames and return it
+	test_exception make_exception_at_depth(const size_t &prm_depth ///< The number of nested frames from which to throw
+	                                       ) {
+		try {
+			call_at_depth( prm_depth, [] {
+				if ( should_throw.load( ::std::memory_order_relaxed ) ) {
+					TELL_THROW( test_exception{} );
+				}
+			} );
+		}
+		catch (const test_exception &exception) {
+			return exception;
+		}
+		return {};
+	}
+
+	/// \brief Check that each call of the specified function makes at most the specified number of allocations, report the result and return whether it passed
+	///
+	/// The function is first called once (unchecked) to warm up any caches (such as the symbol_cache).
+	template <typename Fn>
+	bool check_allocations(const ::std::string &prm_name,            ///< The name of the operation
+	                       const size_t        &prm_max_allocations, ///< The documented maximum number of allocations per call
+	                       Fn                 &&prm_fn               ///< The function that performs the operation
+	                       ) {
+		prm_fn();
+		size_t max_allocations = 0;
+		for (size_t call_ctr = 0; call_ctr < num_calls; ++call_ctr) {
+			const size_t allocs_before = num_allocations.load();
+			prm_fn();
+			max_allocations = ::std::max( max_allocations, num_allocations.load() - allocs_before );
+		}
+		const bool passed = ( max_allocations <= prm_max_allocations );
+		cout << ::boost::format( "%s: %s made up to %d allocations per call (documented maximum: %d)\n" )
+			% ( passed ? "PASS" : "FAIL" )
+			% prm_name
+			% max_allocations
+			% prm_max_allocations;
+		return passed;
+	}
+
+} // namespace
+
+/// \brief Check the allocation counts of capturing, throwing and rendering, and exit with a non-zero status if any is exceeded
+int main() {
+	bool all_passed = true;
+
+	all_passed &= check_allocations( "raw_frames_t::capture()", 0, [] {
+		const auto frames = ::tell::except::detail::raw_frames_t::capture( 0 );
+		::boost::ignore_unused( frames );
+	} );
+
+	all_passed &= check_allocations( "TELL_THROW + catch (depth 8)", tell_throw_allocations, [] {
+		tell_throw_and_catch_at_depth( 8 );
+	} );
+
+	::tell::except::set_default_capture_depth( ::tell::except::capture_depth::at_most( 16 ) );
+	all_passed &= check_allocations( "TELL_THROW + catch (depth 32, truncated at 16)", tell_throw_allocations, [] {
+		tell_throw_and_catch_at_depth( 32 );
+	} );
+	::tell::except::set_default_capture_depth( ::tell::except::capture_depth::unlimited() );
+
+	::tell::except::set_default_capture_policy( ::tell::except::capture_policy::first_n( 0 ) );
+	all_passed &= check_allocations( "TELL_THROW + catch (capture skipped)", tell_throw_skipped_allocations, [] {
+		tell_throw_and_catch_at_depth( 8 );
+	} );
+	::tell::except::set_default_capture_policy( ::tell::except::capture_policy::always() );
+
+	// The first rendering of an exception memoizes its stacktrace's rendering (which allocates) so
+	// check_allocations()'s warm-up call leaves the checked calls with nothing that need allocate
+	const auto exception = make_exception_at_depth( 8 );
+	all_passed &= check_allocations( "write_exception_info (char_buffer_sink)", 0, [&] {
+		static char buffer[ 65536 ];
+		::tell::except::char_buffer_sink sink{ buffer, sizeof( buffer ) };
+		::tell::except::write_exception_info( sink, exception );
+	} );
+
+	cout << ( all_passed ? "All allocation checks passed\n" : "Some allocation checks failed\n" );
+	return all_passed ? 0 : 1;
+}
+
+// g++ -I source/src_stacktrace -W -Wall -Werror -Wextra -pedantic -Wcast-qual -Wconversion -Wnon-virtual-dtor -Wshadow -Wsign-compare -Wsign-conversion -rdynamic -O2 -g -std=c++14 stacktrace_allocation_test.cpp -DBOOST_STACKTRACE_DYN_LINK -isystem /opt/boost_1_67_0_gcc_c++14_build/include -Wl,-rpath,/opt/boost_1_67_0_gcc_c++14_build/lib /opt/boost_1_67_0_gcc_c++14_build/lib/libboost_stacktrace_basic-mt-d.so -o stacktrace_allocation_test.gcc_basic_bin && ./stacktrace_allocation_test.gcc_basic_bin
+//
+// Add -DTELL_USE_RAW_FRAMES (which reduces the expected allocations of TELL_THROW()), -DTELL_USE_ELF_SYMBOLIZER and/or -DTELL_ENABLE_INSTRUMENTATION to test those options
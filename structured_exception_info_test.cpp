@@ -0,0 +1,291 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/core/demangle.hpp>
+#include <boost/format.hpp>
+
+#include "tell/capture_policy.hpp"
+#include "tell/detail/captured_frames.hpp"
+#include "tell/detail/loaded_module_map.hpp"
+#include "tell/structured_exception_info.hpp"
+#include "tell/tell_throw.hpp"
+
+/// \file
+/// \brief A test of the JSON and binary renderings of exception info in structured_exception_info.hpp
+///
+/// This checks the JSON string escaping exactly, checks the JSON of exceptions thrown via TELL_THROW() with the
+/// capture skipped, captured and truncated, and parses the binary records back field-by-field to check every field.
+/// It exits with a non-zero status if any check fails.
+
+using ::std::cout;
+
+namespace {
+
+	/// \brief The number of checks that have failed
+	size_t num_failures = 0;
+
+	/// \brief Record and report the specified check
+	void check(const bool          &prm_passed,     ///< Whether the check passed
+	           const ::std::string &prm_description ///< A description of the check
+	           ) {
+		if ( ! prm_passed ) {
+			++num_failures;
+		}
+		cout << ( prm_passed ? "PASS: " : "FAIL: " ) << prm_description << "\n";
+	}
+
+	/// \brief A message with every kind of char that JSON requires to be escaped, plus some that it doesn't (including UTF-8)
+	const ::std::string awkward_message{ "a \"quoted\" back\\slash\b\f\n\r\t \x01\x1f\x7f caf\xc3\xa9" };
+
+	/// \brief awkward_message, as a JSON string
+	const ::std::string awkward_message_json{ "\"a \\\"quoted\\\" back\\\\slash\\b\\f\\n\\r\\t \\u0001\\u001f\x7f caf\xc3\xa9\"" };
+
+	/// \brief The exception type thrown in the tests, with awkward_message as its what()
+	struct test_exception : public virtual ::boost::exception,
+	                        public virtual ::std::exception {
+		/// \brief Return awkward_message
+		const char * what() const noexcept final {
+			return awkward_message.c_str();
+		}
+	};
+
+	/// \brief A counter incremented after each nested call in call_at_depth(), which stops the calls being tail calls
+	::std::atomic<size_t> num_nested_returns{ 0 };
+
+	/// \brief Call the specified function from within the specified number of nested (non-inlined) frames
+	template <typename Fn>
+	BOOST_NOINLINE void call_at_depth(const size_t  &prm_depth, ///< The number of nested frames from which to call the function
+	                                  Fn           &&prm_fn     ///< The function to call
+	                                  ) {
+		if ( prm_depth <= 1 ) {
+			prm_fn();
+		}
+		else {
+			call_at_depth( prm_depth - 1, prm_fn );
+		}
+		num_nested_returns.fetch_add( 1, ::std::memory_order_relaxed );
+	}
+
+	/// \brief Whether the tests' TELL_THROW()s should throw (always true; this just stops GCC judging call_at_depth() infinitely recursive)
+	::std::atomic<bool> should_throw{ true };
+
+	/// \brief Throw a test_exception via TELL_THROW() from within the specified number of nested frames and return it
+	test_exception make_exception_at_depth(const size_t &prm_depth ///< The number of nested frames from which to throw
+	                                       ) {
+		try {
+			call_at_depth( prm_depth, [] {
+				if ( should_throw.load( ::std::memory_order_relaxed ) ) {
+					TELL_THROW( test_exception{} );
+				}
+			} );
+		}
+		catch (const test_exception &exception) {
+			return exception;
+		}
+		return {};
+	}
+
+	/// \brief Render the specified chars as a JSON string via write_json_string()
+	::std::string json_string(const ::std::string &prm_string ///< The chars to render
+	                          ) {
+		::std::string               result;
+		::tell::except::string_sink sink{ result };
+		::tell::except::detail::write_json_string( sink, prm_string.data(), prm_string.size() );
+		return result;
+	}
+
+	/// \brief Get the JSON members that precede the stacktrace for the specified exception (without the object's opening brace)
+	::std::string expected_json_members(const test_exception &prm_exception ///< The exception
+	                                    ) {
+		return "\"type\":"            + json_string( ::boost::core::demangle( typeid( prm_exception ).name() ) )
+		     + ",\"throw_function\":" + json_string( *::boost::get_error_info< ::boost::throw_function >( prm_exception ) )
+		     + ",\"throw_file\":"     + json_string( *::boost::get_error_info< ::boost::throw_file     >( prm_exception ) )
+		     + ",\"throw_line\":"     + ::std::to_string( *::boost::get_error_info< ::boost::throw_line >( prm_exception ) )
+		     + ",\"what\":"           + awkward_message_json;
+	}
+
+	/// \brief Get the addresses of the frames captured in the specified exception
+	::std::vector<uintptr_t> captured_addresses(const test_exception &prm_exception ///< The exception
+	                                            ) {
+		::std::vector<uintptr_t> addresses;
+		::tell::except::detail::visit_captured_frames( prm_exception, [&] (const auto &x) {
+			for (const auto &frame : x) {
+				addresses.push_back( reinterpret_cast<uintptr_t>( ::tell::except::detail::frame_address( frame ) ) );
+			}
+		} );
+		return addresses;
+	}
+
+	/// \brief Count the (non-overlapping) occurrences of the specified string in the specified text
+	size_t count_occurrences(const ::std::string &prm_text,  ///< The text to search
+	                         const ::std::string &prm_string ///< The string to count
+	                         ) {
+		size_t num_occurrences = 0;
+		for (size_t pos = prm_text.find( prm_string ); pos != ::std::string::npos; pos = prm_text.find( prm_string, pos + prm_string.size() )) {
+			++num_occurrences;
+		}
+		return num_occurrences;
+	}
+
+	/// \brief A field parsed from the binary format
+	struct binary_field final {
+		/// \brief The field's tag
+		::tell::except::binary_field_tag tag;
+
+		/// \brief The field's payload
+		::std::string                    payload;
+
+		/// \brief The payload as a little-endian integer
+		uint64_t integer() const {
+			uint64_t value = 0;
+			for (size_t byte_ctr = 0; byte_ctr < payload.size() && byte_ctr < 8; ++byte_ctr) {
+				value |= ( static_cast<uint64_t>( static_cast<unsigned char>( payload[ byte_ctr ] ) ) << ( 8 * byte_ctr ) );
+			}
+			return value;
+		}
+	};
+
+	/// \brief Parse the specified binary record into its fields, checking its header, that it ends with its END field and that there's nothing after that
+	::std::vector<binary_field> parse_binary(const ::std::string &prm_name,  ///< The name of the record (for the report)
+	                                         const ::std::string &prm_record ///< The binary record
+	                                         ) {
+		check( prm_record.compare( 0, 5, ::std::string{ "TELL" } + static_cast<char>( ::tell::except::binary_format_version ) ) == 0, prm_name + ": binary magic and version" );
+		::std::vector<binary_field> fields;
+		size_t pos = 5;
+		bool   ended = false;
+		while ( ! ended && pos + 5 <= prm_record.size() ) {
+			uint32_t length = 0;
+			for (size_t byte_ctr = 0; byte_ctr < 4; ++byte_ctr) {
+				length |= ( static_cast<uint32_t>( static_cast<unsigned char>( prm_record[ pos + 1 + byte_ctr ] ) ) << ( 8 * byte_ctr ) );
+			}
+			const auto tag = static_cast<::tell::except::binary_field_tag>( prm_record[ pos ] );
+			if ( pos + 5 + length > prm_record.size() ) {
+				break;
+			}
+			fields.push_back( binary_field{ tag, prm_record.substr( pos + 5, length ) } );
+			ended = ( tag == ::tell::except::binary_field_tag::END && length == 0 );
+			pos  += 5 + length;
+		}
+		check( ended && pos == prm_record.size(), prm_name + ": binary fields end with END at the end of the record" );
+		return fields;
+	}
+
+	/// \brief Check the binary fields that precede the stacktrace for the specified exception and return the index of the first field after them
+	size_t check_binary_header_fields(const ::std::string               &prm_name,     ///< The name of the record (for the report)
+	                                  const ::std::vector<binary_field> &prm_fields,   ///< The parsed fields
+	                                  const test_exception              &prm_exception ///< The exception
+	                                  ) {
+		using ::tell::except::binary_field_tag;
+		const auto has_field = [&] (const size_t &x, const binary_field_tag &y) {
+			return x < prm_fields.size() && prm_fields[ x ].tag == y;
+		};
+		check( has_field( 0, binary_field_tag::TYPE           ) && prm_fields[ 0 ].payload   == ::boost::core::demangle( typeid( prm_exception ).name() ),                     prm_name + ": binary TYPE"           );
+		check( has_field( 1, binary_field_tag::THROW_FUNCTION ) && prm_fields[ 1 ].payload   == *::boost::get_error_info< ::boost::throw_function >( prm_exception ),           prm_name + ": binary THROW_FUNCTION" );
+		check( has_field( 2, binary_field_tag::THROW_FILE     ) && prm_fields[ 2 ].payload   == *::boost::get_error_info< ::boost::throw_file     >( prm_exception ),           prm_name + ": binary THROW_FILE"     );
+		check( has_field( 3, binary_field_tag::THROW_LINE     ) && prm_fields[ 3 ].integer() == static_cast<uint64_t>( *::boost::get_error_info< ::boost::throw_line >( prm_exception ) ), prm_name + ": binary THROW_LINE" );
+		check( has_field( 4, binary_field_tag::WHAT           ) && prm_fields[ 4 ].payload   == awkward_message,                                                                prm_name + ": binary WHAT (unescaped)" );
+		return 5;
+	}
+
+	/// \brief Check the binary frame fields starting at the specified index against the specified exception's frames and return the index of the first field after them
+	size_t check_binary_frame_fields(const ::std::string               &prm_name,     ///< The name of the record (for the report)
+	                                 const ::std::vector<binary_field> &prm_fields,   ///< The parsed fields
+	                                 const size_t                      &prm_index,    ///< The index of the first frame field
+	                                 const test_exception              &prm_exception ///< The exception
+	                                 ) {
+		using ::tell::except::binary_field_tag;
+		const auto addresses    = captured_addresses( prm_exception );
+		size_t     index        = prm_index;
+		bool       frames_match = true;
+		for (const auto &address : addresses) {
+			if ( index >= prm_fields.size() || prm_fields[ index ].tag != binary_field_tag::FRAME_ADDRESS || prm_fields[ index ].integer() != address ) {
+				frames_match = false;
+				break;
+			}
+			++index;
+			const auto the_module = ::tell::except::detail::loaded_module_map::instance().find_shared( address );
+			while ( index < prm_fields.size() && static_cast<uint8_t>( prm_fields[ index ].tag ) > static_cast<uint8_t>( binary_field_tag::FRAME_ADDRESS ) ) {
+				if ( prm_fields[ index ].tag == binary_field_tag::FRAME_MODULE_OFFSET && ( ! the_module || prm_fields[ index ].integer() != address - the_module->load_bias ) ) {
+					frames_match = false;
+				}
+				++index;
+			}
+		}
+		check( frames_match && ! addresses.empty(), prm_name + ": binary has the " + ::std::to_string( addresses.size() ) + " frames' addresses, in order, with their module offsets" );
+		return index;
+	}
+
+} // namespace
+
+/// \brief Check the JSON and binary renderings of exception info and exit with a non-zero status if any check fails
+int main() {
+	using ::tell::except::binary_field_tag;
+	using ::tell::except::capture_depth;
+	using ::tell::except::capture_policy;
+
+	// JSON string escaping
+	check( json_string( awkward_message ) == awkward_message_json, "JSON escaping of quotes, backslashes and control chars (but not DEL or UTF-8)" );
+	check( json_string( ""              ) == "\"\"",              "JSON escaping of an empty string" );
+	check( json_string( ::std::string{ "\0", 1 } ) == "\"\\u0000\"", "JSON escaping of a NUL" );
+
+	::tell::except::set_default_capture_policy( capture_policy::first_n( 0 ) );
+	const auto skipped_exception   = make_exception_at_depth( 8 );
+	::tell::except::set_default_capture_policy( capture_policy::always() );
+	const auto captured_exception  = make_exception_at_depth( 8 );
+	::tell::except::set_default_capture_depth( capture_depth::at_most( 4 ) );
+	const auto truncated_exception = make_exception_at_depth( 16 );
+	::tell::except::set_default_capture_depth( capture_depth::unlimited() );
+
+	// JSON
+	{
+		const auto skipped_json = ::tell::except::retrieve_exception_info_json( skipped_exception );
+		check( skipped_json == "{" + expected_json_members( skipped_exception ) + ",\"stacktrace_skipped_by\":" + json_string( to_string( capture_policy::first_n( 0 ) ) ) + "}",
+			"skipped: JSON" );
+
+		const auto captured_json = ::tell::except::retrieve_exception_info_json( captured_exception );
+		const auto num_captured  = captured_addresses( captured_exception ).size();
+		check( captured_json.compare( 0, expected_json_members( captured_exception ).size() + 1, "{" + expected_json_members( captured_exception ) ) == 0,
+			"captured: JSON members before the stacktrace" );
+		check( count_occurrences( captured_json, ",\"stacktrace\":[{\"address\":\"0x" ) == 1,              "captured: JSON stacktrace array opened once" );
+		check( count_occurrences( captured_json, "{\"address\":\"0x" ) == num_captured && num_captured > 0, "captured: JSON has the " + ::std::to_string( num_captured ) + " frames" );
+		check( captured_json.size() >= 3 && captured_json.compare( captured_json.size() - 3, 3, "}]}" ) == 0, "captured: JSON stacktrace and object closed" );
+
+		const auto truncated_json = ::tell::except::retrieve_exception_info_json( truncated_exception );
+		const auto truncated_end  = ::std::string{ "}],\"stacktrace_truncated_after\":4}" };
+		check( count_occurrences( truncated_json, "{\"address\":\"0x" ) == 4, "truncated: JSON has the 4 kept frames" );
+		check( truncated_json.size() >= truncated_end.size() && truncated_json.compare( truncated_json.size() - truncated_end.size(), truncated_end.size(), truncated_end ) == 0,
+			"truncated: JSON has the truncation after the closed stacktrace" );
+	}
+
+	// Binary
+	{
+		const auto skipped_fields = parse_binary( "skipped", ::tell::except::retrieve_exception_info_binary( skipped_exception ) );
+		const auto skipped_index  = check_binary_header_fields( "skipped", skipped_fields, skipped_exception );
+		check( skipped_fields.size() == skipped_index + 2
+			&& skipped_fields[ skipped_index ].tag     == binary_field_tag::STACKTRACE_SKIPPED_BY
+			&& skipped_fields[ skipped_index ].payload == to_string( capture_policy::first_n( 0 ) ),
+			"skipped: binary STACKTRACE_SKIPPED_BY and no frames" );
+
+		const auto captured_fields = parse_binary( "captured", ::tell::except::retrieve_exception_info_binary( captured_exception ) );
+		const auto captured_index  = check_binary_frame_fields( "captured", captured_fields, check_binary_header_fields( "captured", captured_fields, captured_exception ), captured_exception );
+		check( captured_fields.size() == captured_index + 1, "captured: binary has nothing but END after the frames" );
+
+		const auto truncated_fields = parse_binary( "truncated", ::tell::except::retrieve_exception_info_binary( truncated_exception ) );
+		const auto truncated_index  = check_binary_frame_fields( "truncated", truncated_fields, check_binary_header_fields( "truncated", truncated_fields, truncated_exception ), truncated_exception );
+		check( truncated_fields.size() == truncated_index + 2
+			&& truncated_fields[ truncated_index ].tag       == binary_field_tag::STACKTRACE_TRUNCATED
+			&& truncated_fields[ truncated_index ].integer() == 4,
+			"truncated: binary STACKTRACE_TRUNCATED after the 4 kept frames" );
+	}
+
+	cout << ::boost::format( "%d check(s) failed\n" ) % num_failures;
+	return ( num_failures == 0 ) ? 0 : 1;
+}
+
+// g++ -I source/src_stacktrace -W -Wall -Werror -Wextra -pedantic -Wcast-qual -Wconversion -Wnon-virtual-dtor -Wshadow -Wsign-compare -Wsign-conversion -rdynamic -O2 -g -std=c++14 structured_exception_info_test.cpp -DBOOST_STACKTRACE_DYN_LINK -isystem /opt/boost_1_67_0_gcc_c++14_build/include -Wl,-rpath,/opt/boost_1_67_0_gcc_c++14_build/lib /opt/boost_1_67_0_gcc_c++14_build/lib/libboost_stacktrace_basic-mt-d.so -ldl -o structured_exception_info_test.gcc_basic_bin && ./structured_exception_info_test.gcc_basic_bin
+//
+// Add -DTELL_USE_RAW_FRAMES and/or -DTELL_USE_ELF_SYMBOLIZER to test those options
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tell/detail/elf_build_id.hpp"
+#include "tell/detail/elf_module_index.hpp"
+#include "tell/detail/mapped_file.hpp"
+#include "tell/raw_trace_file.hpp"
+#include "tell/retrieve_exception_info.hpp"
+
+/// \file
+/// \brief The tell_symbolize tool, which symbolizes the records in raw trace files (see raw_trace_file.hpp) offline
+///
+/// Usage: tell_symbolize [--binary <path>]... <trace_file>...
+///
+/// Each module in the records is matched, by GNU build-id, to one of the --binary files or else to
+/// the file at the module's recorded path (if it has the same build-id). Each matched binary is
+/// indexed once and each distinct offset within it is looked up once, however many records use it.
+
+using ::std::cerr;
+using ::std::cout;
+
+namespace {
+
+	using ::tell::except::raw_trace_record;
+	using ::tell::except::symbol_info;
+
+	/// \brief The lookups for the frames in one module, keyed by the frames' offsets
+	using offset_symbols_map = ::std::map<uint64_t, symbol_info>;
+
+	/// \brief Get the key under which to group the specified module's frames: its build-id, or its path if it has no build-id
+	::std::string module_key(const ::tell::except::raw_trace_module &prm_module ///< The module
+	                         ) {
+		return prm_module.build_id.empty() ? ( "path:" + prm_module.path ) : prm_module.build_id;
+	}
+
+	/// \brief A matcher of modules' build-ids to the binaries that have them
+	class binary_matcher final {
+	private:
+		/// \brief The binaries found so far, keyed by build-id
+		::std::map<::std::string, ::std::string> binary_of_build_id;
+
+		/// \brief The paths that have already been examined
+		::std::set<::std::string> examined_paths;
+
+	public:
+		/// \brief Examine the binary at the specified path, so that it can be matched by its build-id
+		///
+		/// \returns The build-id of the binary, or an empty string if it doesn't have one (or can't be read)
+		::std::string add_binary(const ::std::string &prm_path ///< The path of the binary
+		                         ) {
+			examined_paths.insert( prm_path );
+			const ::tell::except::detail::mapped_file file{ prm_path };
+			auto build_id = ::tell::except::detail::find_gnu_build_id_of_elf_file( file );
+			if ( ! build_id.empty() ) {
+				binary_of_build_id.emplace( build_id, prm_path );
+			}
+			return build_id;
+		}
+
+		/// \brief Get the path of the binary to use for the specified module, or an empty string if there isn't one
+		::std::string binary_of(const ::tell::except::raw_trace_module &prm_module ///< The module
+		                        ) {
+			if ( prm_module.build_id.empty() ) {
+				return prm_module.path;
+			}
+			if ( binary_of_build_id.count( prm_module.build_id ) == 0 && examined_paths.count( prm_module.path ) == 0 ) {
+				add_binary( prm_module.path );
+			}
+			const auto find_itr = binary_of_build_id.find( prm_module.build_id );
+			return ( find_itr != binary_of_build_id.end() ) ? find_itr->second : ::std::string{};
+		}
+	};
+
+	/// \brief Write the time at which the specified record was written, in UTC ISO 8601, to the specified sink
+	template <typename Sink>
+	void write_record_time(Sink                   &prm_sink,  ///< The sink to which the time should be written
+	                       const raw_trace_record &prm_record ///< The record
+	                       ) {
+		const auto     seconds = static_cast<::std::time_t>( prm_record.timestamp_ns / 1000000000u );
+		::std::tm      broken_down{};
+		::gmtime_r( &seconds, &broken_down );
+		char           buffer[ 48 ];
+		const size_t   num_date_chars = ::std::strftime( buffer, sizeof( buffer ), "%Y-%m-%dT%H:%M:%S", &broken_down );
+		const int      num_nano_chars = ::std::snprintf(
+			buffer + num_date_chars,
+			sizeof( buffer ) - num_date_chars,
+			".%09luZ",
+			static_cast<unsigned long>( prm_record.timestamp_ns % 1000000000u )
+		);
+		prm_sink.write( buffer, num_date_chars + static_cast<size_t>( ::std::max( num_nano_chars, 0 ) ) );
+	}
+
+	/// \brief Write a description of the specified record to the specified sink, in the same form as tell::except::write_exception_info()
+	template <typename Sink>
+	void write_record(Sink                                                &prm_sink,             ///< The sink to which the description should be written
+	                  const raw_trace_record                              &prm_record,           ///< The record to describe
+	                  const ::std::map<::std::string, offset_symbols_map> &prm_symbols_of_module ///< The lookups for the frames, keyed by module_key()
+	                  ) {
+		using namespace ::tell::except::detail;
+
+		write_cstring( prm_sink, "[" );
+		write_record_time( prm_sink, prm_record );
+		write_cstring( prm_sink, " pid " );
+		write_decimal( prm_sink, static_cast<int64_t>( prm_record.pid ) );
+		write_cstring( prm_sink, "] " );
+		write_thrown_exception_description(
+			prm_sink,
+			prm_record.type_name.c_str(),
+			prm_record.function ? prm_record.function->c_str() : nullptr,
+			prm_record.file     ? prm_record.file->c_str()     : nullptr,
+			prm_record.line.get_ptr(),
+			prm_record.what     ? prm_record.what->c_str()     : nullptr
+		);
+
+		if ( prm_record.capture_skipped_by ) {
+			write_capture_skipped( prm_sink, *prm_record.capture_skipped_by );
+		}
+		else {
+			write_stacktrace_heading( prm_sink, ::boost::none );
+			write_cstring( prm_sink, ":\n" );
+			int64_t frame_ctr = 0;
+			for (const auto &the_frame : prm_record.frames) {
+				symbol_info the_symbol_info;
+				if ( the_frame.module_index ) {
+					const auto &the_module = prm_record.modules[ *the_frame.module_index ];
+					const auto  find_itr   = prm_symbols_of_module.find( module_key( the_module ) );
+					if ( find_itr != prm_symbols_of_module.end() && find_itr->second.count( the_frame.offset ) != 0 ) {
+						the_symbol_info = find_itr->second.at( the_frame.offset );
+					}
+					else {
+						the_symbol_info.module        = the_module.path;
+						the_symbol_info.module_offset = static_cast<uintptr_t>( the_frame.offset );
+					}
+				}
+				write_decimal( prm_sink, frame_ctr++, 4 );
+				prm_sink.write( "  ", 2 );
+				write_frame_description( prm_sink, reinterpret_cast<const void *>( the_frame.offset ), the_symbol_info );
+				prm_sink.write( "\n", 1 );
+			}
+			if ( prm_record.truncated ) {
+				write_truncation_marker( prm_sink, prm_record.frames.size() );
+			}
+		}
+		write_cstring( prm_sink, "\n" );
+	}
+
+} // namespace
+
+int main(int argc, char * argv[]) {
+	const char * const             usage = "Usage: tell_symbolize [--binary <path>]... <trace_file>...\n";
+	binary_matcher                 binaries;
+	::std::vector<::std::string>   trace_files;
+	for (int arg_ctr = 1; arg_ctr < argc; ++arg_ctr) {
+		if ( ::std::strcmp( argv[ arg_ctr ], "--binary" ) == 0 ) {
+			if ( arg_ctr + 1 >= argc ) {
+				cerr << "tell_symbolize: error: --binary needs a path\n" << usage;
+				return 1;
+			}
+			const ::std::string binary_path = argv[ ++arg_ctr ];
+			if ( binaries.add_binary( binary_path ).empty() ) {
+				cerr << "tell_symbolize: warning: " << binary_path << " has no GNU build-id (or isn't a readable ELF file) so won't be matched\n";
+			}
+		}
+		else {
+			trace_files.emplace_back( argv[ arg_ctr ] );
+		}
+	}
+	if ( trace_files.empty() ) {
+		cerr << usage;
+		return 1;
+	}
+
+	// Read all the records
+	::std::vector<raw_trace_record> records;
+	for (const auto &trace_file : trace_files) {
+		const ::tell::except::detail::mapped_file file{ trace_file };
+		if ( file.empty() ) {
+			cerr << "tell_symbolize: warning: couldn't read any records from " << trace_file << "\n";
+			continue;
+		}
+		::tell::except::raw_trace_reader reader{ file.data(), file.size() };
+		raw_trace_record                 the_record;
+		while ( reader.next( the_record ) ) {
+			records.push_back( ::std::move( the_record ) );
+		}
+		if ( ! reader.ok() ) {
+			cerr << "tell_symbolize: warning: ignoring the last " << reader.remaining() << " bytes of " << trace_file << " (an incomplete or malformed record)\n";
+		}
+	}
+
+	// Gather the distinct offsets in each module across all the records, so each is looked up once
+	::std::map<::std::string, ::std::set<uint64_t>> offsets_of_module;
+	::std::map<::std::string, ::std::string>        binary_of_module;
+	for (const auto &the_record : records) {
+		for (const auto &the_frame : the_record.frames) {
+			if ( the_frame.module_index ) {
+				const auto &the_module = the_record.modules[ *the_frame.module_index ];
+				const auto  key        = module_key( the_module );
+				offsets_of_module[ key ].insert( the_frame.offset );
+				if ( binary_of_module.count( key ) == 0 ) {
+					binary_of_module.emplace( key, binaries.binary_of( the_module ) );
+				}
+			}
+		}
+	}
+
+	// Index each matched binary once and look up its offsets in ascending order
+	::std::map<::std::string, offset_symbols_map> symbols_of_module;
+	for (const auto &module_offsets : offsets_of_module) {
+		const auto &binary_path = binary_of_module.at( module_offsets.first );
+		if ( binary_path.empty() ) {
+			continue;
+		}
+		const ::tell::except::detail::elf_module_index index{ binary_path };
+		if ( index.empty() ) {
+			cerr << "tell_symbolize: warning: couldn't read symbols or line information from " << binary_path << "\n";
+			continue;
+		}
+		auto &the_symbols = symbols_of_module[ module_offsets.first ];
+		for (const uint64_t &offset : module_offsets.second) {
+			// Look up the call instruction rather than the return address, which may be in the next line (or function)
+			auto the_symbol_info          = index.lookup( ( offset != 0 ) ? ( offset - 1 ) : offset );
+			the_symbol_info.module        = binary_path;
+			the_symbol_info.module_offset = static_cast<uintptr_t>( offset );
+			the_symbols.emplace( offset, ::std::move( the_symbol_info ) );
+		}
+	}
+
+	auto sink = ::tell::except::detail::as_sink( cout );
+	for (const auto &the_record : records) {
+		write_record( sink, the_record, symbols_of_module );
+	}
+	return 0;
+}
+
+// g++ -I source/src_stacktrace -W -Wall -Werror -Wextra -pedantic -Wcast-qual -Wconversion -Wnon-virtual-dtor -Wshadow -Wsign-compare -Wsign-conversion -O2 -std=c++14 tell_symbolize.cpp -isystem /opt/boost_1_67_0_gcc_c++14_build/include -ldl -o tell_symbolize
+//
+// To write raw trace records for it to symbolize, use tell::except::raw_trace_writer (or write_exception_info_raw_trace())
+// in the program, eg:
+//
+//     static ::tell::except::raw_trace_writer trace_writer{ "/var/tmp/my_program.tell" };
+//     ...
+//     catch (const my::stuff::app_exception_base &exception) {
+//         trace_writer.write( exception );
+//     }
+//
+// then run: ./tell_symbolize --binary ./my_program /var/tmp/my_program.tell
@@ -0,0 +1,70 @@
+#include <stdexcept>
+
+#include <boost/preprocessor/repetition/repeat.hpp>
+#include <boost/preprocessor/stringize.hpp>
+#include <boost/throw_exception.hpp>
+
+#include "tell/tell_throw.hpp"
+
+/// \file
+/// \brief A benchmark of the code size that each throw site adds to the function containing it
+///
+/// This defines 64 functions that each conditionally throw one of eight exception types from one site,
+/// using the throwing method chosen by THROW_SITE_METHOD (see the bottom of the file). Each site's exception
+/// has a distinct message (as real sites' do) so that the compiler can't fold identical sites' code together
+/// and hide any per-site code (eg a template instantiated per site) from the measurements. Compare the sizes
+/// of the site_fn_* functions (the code inlined into each site's function) and the total text size
+/// (which includes the per-type code) between methods, or between versions of tell.
+
+#define THROW_SITE_METHOD_PLAIN 1
+#define THROW_SITE_METHOD_BOOST 2
+#define THROW_SITE_METHOD_TELL  3
+
+#ifndef THROW_SITE_METHOD
+#define THROW_SITE_METHOD THROW_SITE_METHOD_TELL
+#endif
+
+#if THROW_SITE_METHOD == THROW_SITE_METHOD_PLAIN
+#define THROW_SITE_THROW(x) throw (x)
+#elif THROW_SITE_METHOD == THROW_SITE_METHOD_BOOST
+#define THROW_SITE_THROW(x) BOOST_THROW_EXCEPTION(x)
+#else
+#define THROW_SITE_THROW(x) TELL_THROW(x)
+#endif
+
+/// \brief One of several exception types, so that the per-type code is included in the measurements
+template <int N>
+struct site_error : public ::std::invalid_argument {
+	using ::std::invalid_argument::invalid_argument;
+};
+
+/// \brief Define a function that returns double its argument, but throws (one of eight types) from a single site if it's negative
+#define THROW_SITE_DEFINE_FN(z, n, data) \
+	BOOST_NOINLINE int site_fn_ ## n(const int &prm_value) { \
+		if ( prm_value < 0 ) { \
+			THROW_SITE_THROW( site_error< n % 8 >( "negative value passed to site_fn_" BOOST_PP_STRINGIZE( n ) ) ); \
+		} \
+		return prm_value * 2; \
+	}
+
+BOOST_PP_REPEAT(64, THROW_SITE_DEFINE_FN, ~)
+
+/// \brief Add a call to the specified site_fn_*() to the sum
+#define THROW_SITE_CALL_FN(z, n, data) sum += site_fn_ ## n( argc );
+
+int main(int argc, char * /*argv*/ []) {
+	int sum = 0;
+	BOOST_PP_REPEAT(64, THROW_SITE_CALL_FN, ~)
+	return ( sum == 0 ) ? 1 : 0;
+}
+
+// To report the mean number of bytes in each site_fn_* (split into the hot part and any part the compiler moved to a .cold
+// clone) and the total text bytes per site, for each method:
+//
+// for method in 1 2 3; do g++ -I source/src_stacktrace -DTHROW_SITE_METHOD=$method -O2 -std=c++14 -c throw_site_size_benchmark.cpp -isystem /opt/boost_1_67_0_gcc_c++14_build/include -o throw_site_size_benchmark.o && nm -S -t d throw_site_size_benchmark.o | awk -v method=$method '$3 ~ /^[Tt]$/ && $4 ~ /^_Z[0-9]+site_fn_/ { if ( $4 ~ /\.cold$/ ) { cold += $2 } else { hot += $2 } } END { printf "method %d : %5.1f hot + %5.1f cold bytes per site function, ", method, hot / 64, cold / 64 }' && size throw_site_size_benchmark.o | awk 'NR == 2 { printf "%6.1f text bytes per site\n", $1 / 64 }'; done
+//
+// With g++ 12 (-O2), this gave:
+//
+// method 1 :  13.0 hot +  82.0 cold bytes per site function,  240.3 text bytes per site
+// method 2 : 112.0 hot +  20.0 cold bytes per site function,  939.8 text bytes per site
+// method 3 :  88.0 hot +  20.0 cold bytes per site function,  924.2 text bytes per site (before outlining: 985.1 text)